@@ -0,0 +1,104 @@
+#pragma once
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * A tiny benchmark harness, no dependencies. A case is a callable that does `ops` operations per call.
+ * It is first run until one sample takes about a millisecond (that fixes the batch size), then timed
+ * for a number of samples. Each sample gives one ns/op figure, the report is their mean and spread.
+ */
+
+/**
+ * @brief Keep the compiler from throwing away a result that is never read.
+ * @param value The result
+ */
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    volatile const char* sink = reinterpret_cast<volatile const char*>(&value);
+    (void)*sink;
+#else
+    asm volatile("" : : "r,m"(value) : "memory");
+#endif
+}
+
+/**
+ * @brief The measurements of one case.
+ */
+struct BenchResult {
+    std::string name;
+    uint64_t ops_per_sample = 0;   // Operations timed in one sample
+    double mean_ns = 0.0;          // Mean time per operation
+    double stddev_ns = 0.0;        // Standard deviation of the per sample ns/op
+    double min_ns = 0.0;           // Fastest sample
+    double max_ns = 0.0;           // Slowest sample
+
+    /**
+     * @return Operations per second at the mean time
+     */
+    double Throughput() const { return mean_ns > 0.0 ? 1e9 / mean_ns : 0.0; }
+
+    /**
+     * @return Standard deviation relative to the mean, in percent
+     */
+    double RelativeStddev() const { return mean_ns > 0.0 ? 100.0 * stddev_ns / mean_ns : 0.0; }
+};
+
+/**
+ * @brief Time one case.
+ * @param name Name of the case in the report
+ * @param ops Operations done by one call of func
+ * @param samples Number of timed samples
+ * @param func The case
+ * @return The measurements
+ */
+template <typename Func>
+BenchResult RunBenchmark(const std::string& name, uint64_t ops, int samples, Func&& func) {
+    using Clock = std::chrono::steady_clock;
+
+    // Warm up and grow the batch until one sample is long enough for the clock
+    uint64_t calls = 1;
+    for (;;) {
+        Clock::time_point start = Clock::now();
+        for (uint64_t i = 0; i < calls; ++i) {
+            func();
+        }
+        double elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        if (elapsed >= 1e6 || calls >= (uint64_t(1) << 30)) {
+            break;
+        }
+        calls *= 2;
+    }
+
+    std::vector<double> ns_per_op(samples);
+    for (int s = 0; s < samples; ++s) {
+        Clock::time_point start = Clock::now();
+        for (uint64_t i = 0; i < calls; ++i) {
+            func();
+        }
+        double elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        ns_per_op[s] = elapsed / double(calls * ops);
+    }
+
+    BenchResult res;
+    res.name = name;
+    res.ops_per_sample = calls * ops;
+    res.min_ns = ns_per_op[0];
+    res.max_ns = ns_per_op[0];
+    double sum = 0.0;
+    for (double v : ns_per_op) {
+        sum += v;
+        res.min_ns = v < res.min_ns ? v : res.min_ns;
+        res.max_ns = v > res.max_ns ? v : res.max_ns;
+    }
+    res.mean_ns = sum / samples;
+    double var = 0.0;
+    for (double v : ns_per_op) {
+        var += (v - res.mean_ns) * (v - res.mean_ns);
+    }
+    res.stddev_ns = samples > 1 ? std::sqrt(var / (samples - 1)) : 0.0;
+    return res;
+}
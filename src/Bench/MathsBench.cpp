@@ -0,0 +1,209 @@
+/**
+ * Micro benchmarks of the maths layer and the clipper, so a change there shows up as a number.
+ * Builds without the console engine, see Bench/CMakeLists.txt.
+ *
+ * Usage: rasterizer3D_bench [--samples N] [--filter text] [--json file]
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "Benchmark.h"
+#include "../Maths/Vector/Vector3d.h"
+#include "../Maths/Matrix/Mat4x4.h"
+#include "../Maths/Matrix/TransformBatch.h"
+#include "../Maths/Geometry/SphereCullBatch.h"
+#include "../Primitive/Triangle.h"
+#include "../Render/Clipping.h"
+#include "../Platform/CpuFeatures.h"
+
+namespace {
+
+// Every case walks the same pool of inputs so the loop is not a single cached value
+constexpr int POOL_SIZE = 1024;
+
+struct Inputs {
+    std::vector<Vector3d> points;
+    std::vector<Mat4x4> matrices;
+    std::vector<Triangle> triangles;
+    VertexStreamSoA stream;         // The points again as a stream, and quantized to 16 bits in [-10, 10]
+    QuantizedStreamSoA quantized;
+};
+
+Inputs MakeInputs() {
+    Inputs in;
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> coord(-10.0f, 10.0f);
+    std::uniform_real_distribution<float> angle(-PI, PI);
+
+    for (int i = 0; i < POOL_SIZE; ++i) {
+        in.points.push_back({ coord(rng), coord(rng), coord(rng) });
+        in.matrices.push_back(MakeRotationZ(angle(rng)) * MakeRotationX(angle(rng)) * MakeTranslation(coord(rng), coord(rng), coord(rng)));
+
+        // Random triangles around x = 0, so the clipper sees whole, cut and rejected ones
+        Triangle tri;
+        for (int k = 0; k < 3; ++k) {
+            tri.pts[k] = { coord(rng), coord(rng), coord(rng) };
+        }
+        in.triangles.push_back(tri);
+    }
+
+    for (const Vector3d& p : in.points) {
+        in.stream.PushBack(p);
+        auto quantize = [](float v) { return (uint16_t)std::lround((v + 10.0f) / 20.0f * 65535.0f); };
+        in.quantized.PushBack(quantize(p.x), quantize(p.y), quantize(p.z));
+    }
+    return in;
+}
+
+struct BenchCase {
+    const char* name;
+    std::function<void()> run;  // Does POOL_SIZE operations
+};
+
+/**
+ * @brief Write the results as JSON.
+ * @param path Output file
+ * @param results The results
+ * @return true if the file was written
+ */
+bool WriteJson(const char* path, const std::vector<BenchResult>& results) {
+    FILE* f = std::fopen(path, "w");
+    if (!f) {
+        std::cerr << "Cannot open " << path << " for writing." << std::endl;
+        return false;
+    }
+    std::fprintf(f, "{\n  \"cpu_level\": \"%s\",\n  \"benchmarks\": [\n", CpuLevelName(ActiveCpuLevel()));
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        std::fprintf(f, "    { \"name\": \"%s\", \"ops\": %llu, \"ns_per_op\": %.4f, \"stddev_ns\": %.4f, "
+                        "\"min_ns\": %.4f, \"max_ns\": %.4f, \"ops_per_sec\": %.1f }%s\n",
+                     r.name.c_str(), (unsigned long long)r.ops_per_sample, r.mean_ns, r.stddev_ns,
+                     r.min_ns, r.max_ns, r.Throughput(), i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(f, "  ]\n}\n");
+    std::fclose(f);
+    return true;
+}
+
+}
+
+int main(int argc, char** argv) {
+    int samples = 30;
+    const char* filter = nullptr;
+    const char* json_path = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--samples") == 0 && i + 1 < argc) {
+            samples = std::max(2, std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        }
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--samples N] [--filter text] [--json file]" << std::endl;
+            return 1;
+        }
+    }
+
+    Inputs in = MakeInputs();
+    const Vector3d up = { 0.0f, 1.0f, 0.0f };
+    HomogeneousStreamSoA transformed;
+    // A camera at the origin looking down +z, so about half of the points are in view
+    const Frustum frustum(MakeProjection(90.0f, 1.0f, 0.1f, 1000.0f), 0.1f);
+    std::vector<uint32_t> visible(POOL_SIZE);
+
+    std::vector<BenchCase> cases = {
+        { "MultiplyMatrixVector", [&] {
+            for (int i = 0; i < POOL_SIZE; ++i) {
+                Vector3d out;
+                MultiplyMatrixVector(in.points[i], out, in.matrices[i]);
+                DoNotOptimize(out);
+            }
+        } },
+        { "MultiplyMatrix", [&] {
+            for (int i = 0; i < POOL_SIZE; ++i) {
+                Mat4x4 out = MultiplyMatrix(in.matrices[i], in.matrices[(i + 1) & (POOL_SIZE - 1)]);
+                DoNotOptimize(out);
+            }
+        } },
+        { "Inverse", [&] {
+            for (int i = 0; i < POOL_SIZE; ++i) {
+                Mat4x4 out = Inverse(in.matrices[i]);
+                DoNotOptimize(out);
+            }
+        } },
+        { "PointAt", [&] {
+            for (int i = 0; i < POOL_SIZE; ++i) {
+                Mat4x4 out = PointAt(in.points[i], in.points[(i + 1) & (POOL_SIZE - 1)], up);
+                DoNotOptimize(out);
+            }
+        } },
+        { "Normalize", [&] {
+            for (int i = 0; i < POOL_SIZE; ++i) {
+                Vector3d out = NormalizeToNew(in.points[i]);
+                DoNotOptimize(out);
+            }
+        } },
+        { "CrossProduct", [&] {
+            for (int i = 0; i < POOL_SIZE; ++i) {
+                Vector3d out = CrossProduct(in.points[i], in.points[(i + 1) & (POOL_SIZE - 1)]);
+                DoNotOptimize(out);
+            }
+        } },
+        { "IntersectPlane", [&] {
+            for (int i = 0; i < POOL_SIZE; ++i) {
+                Vector3d out = IntersectPlane({ 0.0f, 0.0f, 0.0f }, up, in.points[i], in.points[(i + 1) & (POOL_SIZE - 1)]);
+                DoNotOptimize(out);
+            }
+        } },
+        { "TransformPointsSoA", [&] {
+            TransformPointsSoA(in.stream, transformed, in.matrices[0]);
+            DoNotOptimize(transformed.x[0]);
+        } },
+        { "TransformQuantized", [&] {
+            TransformQuantizedPointsSoA(in.quantized, transformed, in.matrices[0]);
+            DoNotOptimize(transformed.x[0]);
+        } },
+        { "CullSpheresSoA", [&] {
+            size_t n = CullSpheresSoA(in.stream.x.data(), in.stream.y.data(), in.stream.z.data(), 0.5f, POOL_SIZE, frustum, visible.data());
+            DoNotOptimize(n);
+        } },
+        { "ClipAgainstPlane", [&] {
+            for (int i = 0; i < POOL_SIZE; ++i) {
+                Triangle o1, o2;
+                int n = ClipAgainstPlane({ 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, in.triangles[i], o1, o2);
+                DoNotOptimize(n);
+                DoNotOptimize(o1);
+                DoNotOptimize(o2);
+            }
+        } },
+    };
+
+    std::printf("CPU tier: %s, %d samples per case\n\n", CpuLevelName(ActiveCpuLevel()), samples);
+    std::printf("%-22s %10s %10s %8s %14s\n", "benchmark", "ns/op", "stddev", "rsd %", "ops/s");
+
+    std::vector<BenchResult> results;
+    for (const BenchCase& c : cases) {
+        if (filter && !std::strstr(c.name, filter)) {
+            continue;
+        }
+        BenchResult r = RunBenchmark(c.name, POOL_SIZE, samples, c.run);
+        std::printf("%-22s %10.3f %10.3f %8.2f %14.4g\n", r.name.c_str(), r.mean_ns, r.stddev_ns, r.RelativeStddev(), r.Throughput());
+        results.push_back(r);
+    }
+
+    if (json_path && !WriteJson(json_path, results)) {
+        return 1;
+    }
+    return 0;
+}
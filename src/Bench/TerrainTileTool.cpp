@@ -0,0 +1,73 @@
+/**
+ * Cuts a terrain OBJ into tiles for PagedTerrain and reports what went into them.
+ * The OBJ goes through its mesh cache, so a terrain that was loaded before is read straight from the mapping.
+ *
+ * Usage: rasterizer3D_tiler [--tiles N] [--coarse ratio] [--out terrain.tiles] file.obj
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "../Loader/MeshCache.h"
+#include "../Loader/ObjParser.h"
+#include "../Loader/TerrainTiles.h"
+#include "../Primitive/Mesh.h"
+
+int main(int argc, char** argv) {
+    int tiles = 8;
+    float coarse = 0.1f;
+    const char* out_path = nullptr;
+    const char* in_path = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--tiles") == 0 && i + 1 < argc) {
+            tiles = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--coarse") == 0 && i + 1 < argc) {
+            coarse = std::min(std::max((float)std::atof(argv[++i]), 0.001f), 1.0f);
+        }
+        else if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+        }
+        else {
+            in_path = argv[i];
+        }
+    }
+    if (!in_path) {
+        std::fprintf(stderr, "Usage: %s [--tiles N] [--coarse ratio] [--out terrain.tiles] file.obj\n", argv[0]);
+        return 1;
+    }
+    std::string index_path = out_path ? out_path : std::string(in_path) + ".tiles";
+
+    Mesh mesh;
+    if (!LoadObjCached(in_path, mesh)) {
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    if (!BuildTerrainTiles(mesh, (uint32_t)tiles, (uint32_t)tiles, coarse, index_path)) {
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    TerrainIndexHeader header;
+    std::vector<TerrainTileInfo> infos;
+    if (!LoadTerrainIndex(index_path, header, infos)) {
+        return 1;
+    }
+    size_t used = 0, bytes = 0, coarse_bytes = 0, largest = 0;
+    for (const TerrainTileInfo& info : infos) {
+        used += info.triangles > 0;
+        bytes += (size_t)info.bytes;
+        coarse_bytes += (size_t)info.coarse_bytes;
+        largest = std::max(largest, (size_t)(info.bytes + info.coarse_bytes));
+    }
+    std::printf("%s: %zu triangles into %ux%u tiles (%zu used) in %.1f s\n", in_path, mesh.TriangleCount(),
+                header.tiles_x, header.tiles_z, used, seconds);
+    std::printf("full %.1f MB, coarse %.1f MB, largest tile %.2f MB, index %s\n",
+                bytes * 1e-6, coarse_bytes * 1e-6, largest * 1e-6, index_path.c_str());
+    return 0;
+}
@@ -0,0 +1,153 @@
+#include <iostream>
+#include "AsyncMeshLoader.h"
+#include "../Primitive/Mesh.h"
+
+AsyncMeshLoader::AsyncMeshLoader() {
+    worker_ = std::thread(&AsyncMeshLoader::WorkerLoop, this);
+}
+
+AsyncMeshLoader::~AsyncMeshLoader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    worker_.join();
+}
+
+std::shared_ptr<MeshAsset> AsyncMeshLoader::Load(const std::string& filename, const MeshLoadOptions& options) {
+    auto asset = std::make_shared<MeshAsset>();
+    asset->filename_ = filename;
+    asset->options_ = options;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(asset);
+        watched_.push_back(asset);
+    }
+    wake_.notify_all();
+    return asset;
+}
+
+void AsyncMeshLoader::Reload(const std::shared_ptr<MeshAsset>& asset) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(asset);
+    }
+    wake_.notify_all();
+}
+
+void AsyncMeshLoader::SetHotReload(bool enabled, std::chrono::milliseconds interval) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        hot_reload_ = enabled;
+        interval_ = interval;
+    }
+    wake_.notify_all();
+}
+
+size_t AsyncMeshLoader::Pending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size() + running_;
+}
+
+void AsyncMeshLoader::WorkerLoop() {
+    auto next_poll = std::chrono::steady_clock::now();
+    for (;;) {
+        std::shared_ptr<MeshAsset> job;
+        bool poll = false;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            auto ready = [this] { return stop_ || !queue_.empty(); };
+            if (hot_reload_) {
+                poll = !wake_.wait_until(lock, next_poll, ready);
+            }
+            else {
+                wake_.wait(lock, [this] { return stop_ || hot_reload_ || !queue_.empty(); });
+            }
+            if (stop_) {
+                return;
+            }
+            if (!queue_.empty()) {
+                job = std::move(queue_.front());
+                queue_.pop_front();
+                ++running_;
+            }
+        }
+
+        if (job) {
+            LoadNow(*job);
+            std::lock_guard<std::mutex> lock(mutex_);
+            --running_;
+        }
+        if (poll) {
+            PollChanges();
+            std::lock_guard<std::mutex> lock(mutex_);
+            next_poll = std::chrono::steady_clock::now() + interval_;
+        }
+    }
+}
+
+void AsyncMeshLoader::LoadNow(MeshAsset& asset) {
+    // Stamp first, so a change made during the load is seen by the next poll
+    const std::string path = ObjectFilePath(asset.filename_);
+    SourceStamp stamp;
+    StampSourceFile(path, false, stamp);
+
+    Mesh mesh;
+    if (!mesh.LoadFromObjFile(asset.filename_)) {
+        std::cerr << "Loading " << asset.filename_ << " failed, keeping the previous version.\n";
+        asset.failed_.store(true, std::memory_order_release);
+        asset.loaded_stamp_ = stamp;
+        asset.seen_stamp_ = stamp;
+        return;
+    }
+
+    auto lod = std::make_shared<MeshLod>();
+    const MeshLoadOptions& options = asset.options_;
+    BuildMeshLod(std::move(mesh), options.lod_levels, options.lod_ratio, options.lod_min_triangles, *lod);
+
+    // The handoff: the render loop sees either the old mesh or the whole new one
+    std::atomic_store_explicit(&asset.current_, std::shared_ptr<const MeshLod>(std::move(lod)), std::memory_order_release);
+    asset.loaded_stamp_ = stamp;
+    asset.seen_stamp_ = stamp;
+    asset.failed_.store(false, std::memory_order_release);
+    asset.generation_.fetch_add(1, std::memory_order_acq_rel);
+}
+
+void AsyncMeshLoader::PollChanges() {
+    std::vector<std::shared_ptr<MeshAsset>> assets;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < watched_.size();) {
+            if (auto asset = watched_[i].lock()) {
+                assets.push_back(std::move(asset));
+                ++i;
+            }
+            else {
+                // Nobody holds the asset any more, stop watching it
+                watched_[i] = std::move(watched_.back());
+                watched_.pop_back();
+            }
+        }
+    }
+
+    for (const auto& asset : assets) {
+        SourceStamp stamp;
+        if (!StampSourceFile(ObjectFilePath(asset->filename_), false, stamp)) {
+            continue;
+        }
+        auto same = [](const SourceStamp& a, const SourceStamp& b) { return a.size == b.size && a.mtime == b.mtime; };
+        if (same(stamp, asset->loaded_stamp_)) {
+            continue;
+        }
+
+        // Changed since the load, reload only once it stopped changing
+        if (same(stamp, asset->seen_stamp_)) {
+            std::cerr << asset->filename_ << " changed, reloading.\n";
+            LoadNow(*asset);
+        }
+        else {
+            asset->seen_stamp_ = stamp;
+        }
+    }
+}
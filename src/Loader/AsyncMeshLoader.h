@@ -0,0 +1,129 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "MeshCache.h"
+#include "../Primitive/MeshLod.h"
+
+/**
+ * @brief How a mesh is prepared once it is loaded.
+ */
+struct MeshLoadOptions {
+    int lod_levels = 1;             // Levels of detail including the full mesh, 1 for the mesh alone
+    float lod_ratio = 0.5f;         // See BuildMeshLod
+    size_t lod_min_triangles = 256;
+};
+
+/**
+ * @brief A mesh that is loaded in the background, and replaced when it is reloaded.
+ * The render loop reads Current() every frame and keeps the pointer for the frame, a reload publishes a whole
+ * new MeshLod so the one being drawn is never modified, it goes away when the last frame using it lets go.
+ */
+class MeshAsset {
+public:
+    /**
+     * @brief The latest finished version, never waits on the loader.
+     * @return The mesh, nullptr until the first load finished
+     */
+    std::shared_ptr<const MeshLod> Current() const { return std::atomic_load_explicit(&current_, std::memory_order_acquire); }
+
+    /**
+     * @return How many versions were published so far, a change means Current() returns a new mesh
+     */
+    uint32_t Generation() const { return generation_.load(std::memory_order_acquire); }
+
+    /**
+     * @return true if the last load attempt failed, Current() still has the version before it
+     */
+    bool Failed() const { return failed_.load(std::memory_order_acquire); }
+
+    /**
+     * @return The name of the obj file in Objects/
+     */
+    const std::string& Filename() const { return filename_; }
+
+private:
+    friend class AsyncMeshLoader;
+
+    std::string filename_;
+    MeshLoadOptions options_;
+    std::shared_ptr<const MeshLod> current_;   // Only accessed through std::atomic_load / std::atomic_store
+    std::atomic<uint32_t> generation_{ 0 };
+    std::atomic<bool> failed_{ false };
+    SourceStamp loaded_stamp_;                 // Worker only: the file as it was when last loaded
+    SourceStamp seen_stamp_;                   // Worker only: the file as it was at the last poll
+};
+
+/**
+ * @brief Loads meshes on a worker thread so the render loop never waits on the disk.
+ *
+ * Load() returns right away with an empty MeshAsset, the worker parses the OBJ (or maps its cache), builds
+ * the levels of detail and then publishes the result into the asset with one atomic store. With hot reload
+ * on, the worker also polls the size and modification time of every file it loaded, and loads it again once
+ * a change has stayed the same for one poll, so a file is not picked up while an editor is still writing it.
+ */
+class AsyncMeshLoader {
+public:
+    AsyncMeshLoader();
+    ~AsyncMeshLoader();
+    AsyncMeshLoader(const AsyncMeshLoader&) = delete;
+    AsyncMeshLoader& operator=(const AsyncMeshLoader&) = delete;
+
+    /**
+     * @brief Queue a mesh for loading.
+     * @param filename Name of the obj file in Objects/
+     * @param options What to build once it is loaded
+     * @return The asset, its Current() becomes non-null when the load finished
+     */
+    std::shared_ptr<MeshAsset> Load(const std::string& filename, const MeshLoadOptions& options = {});
+
+    /**
+     * @brief Queue an asset to be loaded again, whether its file changed or not.
+     * @param asset The asset
+     */
+    void Reload(const std::shared_ptr<MeshAsset>& asset);
+
+    /**
+     * @brief Turn watching the loaded files on or off.
+     * @param enabled Whether changed files are reloaded
+     * @param interval How often the files are checked
+     */
+    void SetHotReload(bool enabled, std::chrono::milliseconds interval = std::chrono::milliseconds(500));
+
+    /**
+     * @return Number of loads queued or running
+     */
+    size_t Pending() const;
+
+private:
+    /**
+     * @brief The worker thread: run queued loads, poll the watched files when hot reload is on.
+     */
+    void WorkerLoop();
+
+    /**
+     * @brief Load and publish one asset, on the worker.
+     */
+    void LoadNow(MeshAsset& asset);
+
+    /**
+     * @brief Queue the watched files that changed since they were loaded, on the worker.
+     */
+    void PollChanges();
+
+    mutable std::mutex mutex_;              // Guards everything below except worker_
+    std::condition_variable wake_;
+    std::deque<std::shared_ptr<MeshAsset>> queue_;
+    std::vector<std::weak_ptr<MeshAsset>> watched_;
+    size_t running_ = 0;                    // Loads taken off the queue and not finished yet
+    bool stop_ = false;
+    bool hot_reload_ = false;
+    std::chrono::milliseconds interval_{ 500 };
+    std::thread worker_;                    // Runs WorkerLoop, started last in the constructor
+};
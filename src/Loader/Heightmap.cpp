@@ -0,0 +1,56 @@
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include "Heightmap.h"
+
+float Heightmap::Sample(float x, float z) const {
+    if (heights.empty()) {
+        return 0.0f;
+    }
+    float fx = x / cell_size;
+    float fz = z / cell_size;
+    float cx = std::floor(fx);
+    float cz = std::floor(fz);
+    float tx = fx - cx;
+    float tz = fz - cz;
+    int64_t ix = (int64_t)cx;
+    int64_t iz = (int64_t)cz;
+    float h0 = At(ix, iz) + (At(ix + 1, iz) - At(ix, iz)) * tx;
+    float h1 = At(ix, iz + 1) + (At(ix + 1, iz + 1) - At(ix, iz + 1)) * tx;
+    return h0 + (h1 - h0) * tz;
+}
+
+bool LoadHeightmapRaw16(const std::string& path, uint32_t width, uint32_t depth, float cell_size, float height_scale, Heightmap& map) {
+    if (width < 2 || depth < 2) {
+        std::cerr << "A heightmap needs at least 2x2 samples.\n";
+        return false;
+    }
+
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) {
+        std::cerr << "The heightmap " << path << " cannot be opened.\n";
+        return false;
+    }
+    size_t count = (size_t)width * depth;
+    if ((uint64_t)in.tellg() != count * 2) {
+        std::cerr << path << " does not hold " << width << "x" << depth << " 16-bit samples.\n";
+        return false;
+    }
+
+    std::vector<unsigned char> raw(count * 2);
+    in.seekg(0);
+    if (!in.read(reinterpret_cast<char*>(raw.data()), (std::streamsize)raw.size())) {
+        std::cerr << "The heightmap " << path << " cannot be read.\n";
+        return false;
+    }
+
+    map.width = width;
+    map.depth = depth;
+    map.cell_size = cell_size;
+    map.heights.resize(count);
+    const float scale = height_scale / 65535.0f;
+    for (size_t i = 0; i < count; ++i) {
+        map.heights[i] = (float)(raw[i * 2] | (raw[i * 2 + 1] << 8)) * scale;
+    }
+    return true;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief A regular grid of heights on the XZ plane, sample (0, 0) at the origin and cell_size apart.
+ */
+struct Heightmap {
+    uint32_t width = 0;             // Samples along x
+    uint32_t depth = 0;             // Samples along z
+    float cell_size = 1.0f;         // Distance between two samples
+    std::vector<float> heights;     // width * depth heights, row by row along x
+
+    /**
+     * @brief Height of a sample, clamped to the border.
+     * @param x Column
+     * @param z Row
+     * @return The height
+     */
+    float At(int64_t x, int64_t z) const {
+        x = x < 0 ? 0 : (x >= (int64_t)width ? (int64_t)width - 1 : x);
+        z = z < 0 ? 0 : (z >= (int64_t)depth ? (int64_t)depth - 1 : z);
+        return heights[(size_t)z * width + (size_t)x];
+    }
+
+    /**
+     * @brief Height anywhere on the map, interpolated between the four samples around the point.
+     * @param x World x
+     * @param z World z
+     * @return The height, the border samples continue outside the map
+     */
+    float Sample(float x, float z) const;
+
+    /**
+     * @brief Size of the map along x and z.
+     */
+    float SizeX() const { return (float)(width > 0 ? width - 1 : 0) * cell_size; }
+    float SizeZ() const { return (float)(depth > 0 ? depth - 1 : 0) * cell_size; }
+};
+
+/**
+ * @brief Load a headerless file of 16-bit little-endian samples (.r16/.raw, as heightmap tools write them).
+ * @param path Path of the file
+ * @param width Samples along x
+ * @param depth Samples along z
+ * @param cell_size Distance between two samples
+ * @param height_scale Height of the sample value 65535, 0 maps to 0
+ * @param map Receives the heights
+ * @return true if the file has exactly width * depth samples and was read
+ */
+bool LoadHeightmapRaw16(const std::string& path, uint32_t width, uint32_t depth, float cell_size, float height_scale, Heightmap& map);
@@ -0,0 +1,360 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "MeshCache.h"
+#include "ObjParser.h"
+#include "../Platform/MappedFile.h"
+#include "../Primitive/Mesh.h"
+#include "../Primitive/MeshOptimizer.h"
+
+namespace {
+
+constexpr char MAGIC[8] = { 'R', 'M', 'E', 'S', 'H', 'C', 0, 0 };
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304u;
+constexpr uint64_t BLOCK_ALIGN = 64;
+constexpr uint32_t MAX_RETIRED = 16;   // Old caches kept aside at once, while something still maps them
+
+inline uint64_t AlignUp(uint64_t offset) {
+    return (offset + BLOCK_ALIGN - 1) & ~(BLOCK_ALIGN - 1);
+}
+
+/**
+ * @brief Fill in the block offsets of a cache for the given counts.
+ */
+void LayoutCache(MeshCacheHeader& header) {
+    uint64_t v = header.vertex_count;
+    uint64_t t = header.triangle_count;
+    header.positions_offset = AlignUp(sizeof(MeshCacheHeader));
+    header.indices_offset = AlignUp(header.positions_offset + 3 * AlignUp(v * sizeof(float)));
+    header.normals_offset = AlignUp(header.indices_offset + t * 3 * sizeof(uint32_t));
+    header.meshlets_offset = header.normals_offset + 3 * AlignUp(t * sizeof(float));
+    header.bvh_offset = AlignUp(header.meshlets_offset + header.meshlet_count * sizeof(Meshlet));
+    header.file_size = AlignUp(header.bvh_offset + header.bvh_node_count * sizeof(BvhNode));
+}
+
+/**
+ * @brief Write count floats and pad to the block alignment.
+ */
+void WriteBlock(std::ofstream& out, const void* data, uint64_t bytes) {
+    static const char zeros[BLOCK_ALIGN] = {};
+    out.write(static_cast<const char*>(data), (std::streamsize)bytes);
+    out.write(zeros, (std::streamsize)(AlignUp(bytes) - bytes));
+}
+
+/**
+ * @brief Check that every index stored in a cache stays within the arrays it points into, so a damaged
+ * file is rejected here rather than read out of bounds while drawing.
+ */
+bool CacheIndicesValid(const MeshCacheHeader& header, const char* base) {
+    const uint64_t v = header.vertex_count;
+    const uint64_t t = header.triangle_count;
+    const uint64_t meshlet_count = header.meshlet_count;
+    const uint64_t node_count = header.bvh_node_count;
+
+    const uint32_t* indices = reinterpret_cast<const uint32_t*>(base + header.indices_offset);
+    for (uint64_t i = 0; i < t * 3; ++i) {
+        if (indices[i] >= v) {
+            return false;
+        }
+    }
+
+    const Meshlet* meshlets = reinterpret_cast<const Meshlet*>(base + header.meshlets_offset);
+    for (uint64_t i = 0; i < meshlet_count; ++i) {
+        if ((uint64_t)meshlets[i].triangle_begin + meshlets[i].triangle_count > t) {
+            return false;
+        }
+    }
+
+    // Children always come after their parent, which also rules out cycles
+    const BvhNode* nodes = reinterpret_cast<const BvhNode*>(base + header.bvh_offset);
+    for (uint64_t i = 0; i < node_count; ++i) {
+        const BvhNode& node = nodes[i];
+        if ((uint64_t)node.first + node.count > meshlet_count ||
+            (node.child != 0 && (node.child <= i || (uint64_t)node.child + 1 >= node_count))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Where a cache that is still mapped is moved aside to, the first free one of path.old0 .. path.old15.
+ * @return The path, empty if all are taken
+ */
+std::string RetiredPath(const std::string& path) {
+    for (uint32_t n = 0; n < MAX_RETIRED; ++n) {
+        std::string candidate = path + ".old" + std::to_string(n);
+        std::error_code ec;
+        if (!std::filesystem::exists(candidate, ec) && !ec) {
+            return candidate;
+        }
+    }
+    return std::string();
+}
+
+/**
+ * @brief Delete the caches moved aside before, the ones still mapped stay until a later call.
+ */
+void RemoveRetired(const std::string& path) {
+    for (uint32_t n = 0; n < MAX_RETIRED; ++n) {
+        std::error_code ec;
+        std::filesystem::remove(path + ".old" + std::to_string(n), ec);
+    }
+}
+
+/**
+ * @brief Store a new source time in the header of a cache, the rest of the file is left as it is.
+ */
+bool WriteSourceTime(const std::string& path, int64_t mtime) {
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    if (!file.is_open()) {
+        return false;
+    }
+    file.seekp((std::streamoff)(offsetof(MeshCacheHeader, source) + offsetof(SourceStamp, mtime)));
+    file.write(reinterpret_cast<const char*>(&mtime), sizeof(mtime));
+    return (bool)file;
+}
+
+}
+
+uint64_t HashBytes(const void* data, size_t size) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    const uint64_t mul = 0xFF51AFD7ED558CCDull;
+
+    // Four independent lanes so the multiplies overlap, folded together at the end
+    uint64_t h[4] = { 0x9E3779B97F4A7C15ull, 0xBF58476D1CE4E5B9ull, 0x94D049BB133111EBull, 0x2545F4914F6CDD1Dull };
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        for (int k = 0; k < 4; ++k) {
+            uint64_t w;
+            std::memcpy(&w, p + i + k * 8, 8);
+            h[k] = (h[k] ^ w) * mul;
+            h[k] ^= h[k] >> 29;
+        }
+    }
+    uint64_t res = size;
+    for (int k = 0; k < 4; ++k) {
+        res = (res ^ h[k]) * mul;
+        res ^= res >> 32;
+    }
+    for (; i < size; ++i) {
+        res = (res ^ p[i]) * mul;
+    }
+    return res ^ (res >> 29);
+}
+
+bool StampSourceFile(const std::string& path, bool with_hash, SourceStamp& stamp) {
+    std::error_code ec;
+    uint64_t size = std::filesystem::file_size(path, ec);
+    if (ec) {
+        return false;
+    }
+    auto mtime = std::filesystem::last_write_time(path, ec);
+    if (ec) {
+        return false;
+    }
+    stamp.size = size;
+    stamp.mtime = (int64_t)mtime.time_since_epoch().count();
+    stamp.hash = 0;
+
+    if (with_hash) {
+        MappedFile file;
+        if (!file.Open(path)) {
+            return false;
+        }
+        stamp.hash = HashBytes(file.Data(), file.Size());
+    }
+    return true;
+}
+
+std::string MeshCachePath(const std::string& source_path) {
+    return source_path + ".meshcache";
+}
+
+bool WriteMeshCache(const std::string& path, const Mesh& mesh, const SourceStamp& source) {
+    MeshCacheHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = MESH_CACHE_VERSION;
+    header.byte_order = BYTE_ORDER_MARK;
+    header.vertex_count = mesh.positions.Size();
+    header.triangle_count = mesh.TriangleCount();
+    header.meshlet_count = mesh.meshlets.Size();
+    header.bvh_node_count = mesh.meshlet_bvh.Size();
+    header.bounds_min[0] = mesh.bounds_min.x;
+    header.bounds_min[1] = mesh.bounds_min.y;
+    header.bounds_min[2] = mesh.bounds_min.z;
+    header.bounds_max[0] = mesh.bounds_max.x;
+    header.bounds_max[1] = mesh.bounds_max.y;
+    header.bounds_max[2] = mesh.bounds_max.z;
+    header.source = source;
+    LayoutCache(header);
+
+    std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            std::cerr << "Cannot write the mesh cache " << tmp_path << ".\n";
+            return false;
+        }
+        const uint64_t v_bytes = header.vertex_count * sizeof(float);
+        const uint64_t t_bytes = header.triangle_count * sizeof(float);
+        WriteBlock(out, &header, sizeof(header));
+        WriteBlock(out, mesh.positions.x.Data(), v_bytes);
+        WriteBlock(out, mesh.positions.y.Data(), v_bytes);
+        WriteBlock(out, mesh.positions.z.Data(), v_bytes);
+        WriteBlock(out, mesh.indices.Data(), header.triangle_count * 3 * sizeof(uint32_t));
+        WriteBlock(out, mesh.normals.x.Data(), t_bytes);
+        WriteBlock(out, mesh.normals.y.Data(), t_bytes);
+        WriteBlock(out, mesh.normals.z.Data(), t_bytes);
+        WriteBlock(out, mesh.meshlets.Data(), header.meshlet_count * sizeof(Meshlet));
+        WriteBlock(out, mesh.meshlet_bvh.Data(), header.bvh_node_count * sizeof(BvhNode));
+        if (!out) {
+            std::cerr << "Cannot write the mesh cache " << tmp_path << ".\n";
+            out.close();
+            std::remove(tmp_path.c_str());
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, path, ec);
+    if (ec) {
+        // Windows does not replace a file that is mapped, as the old cache of a hot reloaded mesh still on
+        // screen is. It can be renamed though, so it is moved aside and deleted once nothing maps it
+        std::string retired = RetiredPath(path);
+        std::error_code retire_ec;
+        if (!retired.empty()) {
+            std::filesystem::rename(path, retired, retire_ec);
+            if (!retire_ec) {
+                ec.clear();
+                std::filesystem::rename(tmp_path, path, ec);
+            }
+        }
+    }
+    if (ec) {
+        std::cerr << "Cannot replace the mesh cache " << path << ": " << ec.message() << "\n";
+        std::filesystem::remove(tmp_path, ec);
+        return false;
+    }
+    RemoveRetired(path);
+    return true;
+}
+
+bool LoadMeshCache(const std::string& path, Mesh& mesh, MeshCacheHeader* header_out) {
+    std::error_code ec;
+    if (!std::filesystem::exists(path, ec)) {
+        return false;
+    }
+
+    auto file = std::make_shared<MappedFile>();
+    if (!file->Open(path) || file->Size() < sizeof(MeshCacheHeader)) {
+        return false;
+    }
+
+    MeshCacheHeader header;
+    std::memcpy(&header, file->Data(), sizeof(header));
+
+    // The layout is derived from the counts, so any disagreement means a foreign or damaged file
+    MeshCacheHeader expected = header;
+    LayoutCache(expected);
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != MESH_CACHE_VERSION ||
+        header.byte_order != BYTE_ORDER_MARK || header.vertex_count > UINT32_MAX ||
+        header.positions_offset != expected.positions_offset || header.indices_offset != expected.indices_offset ||
+        header.normals_offset != expected.normals_offset || header.meshlets_offset != expected.meshlets_offset ||
+        header.bvh_offset != expected.bvh_offset || header.file_size != expected.file_size ||
+        header.file_size != file->Size()) {
+        std::cerr << path << " is not a valid mesh cache, it will be rebuilt.\n";
+        return false;
+    }
+
+    const char* base = file->Data();
+    if (!CacheIndicesValid(header, base)) {
+        std::cerr << path << " holds indices out of range, it will be rebuilt.\n";
+        return false;
+    }
+    const size_t v = (size_t)header.vertex_count;
+    const size_t t = (size_t)header.triangle_count;
+    const size_t v_stride = (size_t)AlignUp(v * sizeof(float));
+    const size_t t_stride = (size_t)AlignUp(t * sizeof(float));
+    auto floats = [&](uint64_t offset, size_t count) {
+        return Span<const float>(reinterpret_cast<const float*>(base + offset), count);
+    };
+
+    VertexStreamView positions(floats(header.positions_offset, v),
+                               floats(header.positions_offset + v_stride, v),
+                               floats(header.positions_offset + 2 * v_stride, v));
+    Span<const uint32_t> indices(reinterpret_cast<const uint32_t*>(base + header.indices_offset), t * 3);
+    VertexStreamView normals(floats(header.normals_offset, t),
+                             floats(header.normals_offset + t_stride, t),
+                             floats(header.normals_offset + 2 * t_stride, t));
+    Span<const Meshlet> meshlets(reinterpret_cast<const Meshlet*>(base + header.meshlets_offset), (size_t)header.meshlet_count);
+    Span<const BvhNode> bvh(reinterpret_cast<const BvhNode*>(base + header.bvh_offset), (size_t)header.bvh_node_count);
+    Vector3d bounds_min{ header.bounds_min[0], header.bounds_min[1], header.bounds_min[2] };
+    Vector3d bounds_max{ header.bounds_max[0], header.bounds_max[1], header.bounds_max[2] };
+
+    mesh.SetMapped(std::move(file), positions, indices, normals, meshlets, bvh, bounds_min, bounds_max);
+    if (header_out) {
+        *header_out = header;
+    }
+    return true;
+}
+
+bool LoadObjCached(const std::string& obj_path, Mesh& mesh, ObjLoadStats* stats) {
+    auto start = std::chrono::steady_clock::now();
+
+    SourceStamp source;
+    if (!StampSourceFile(obj_path, false, source)) {
+        std::cerr << "The file " << obj_path << " cannot be opened.\n";
+        return false;
+    }
+
+    // Try the cache first, it is only kept if it was built from this very OBJ
+    const std::string cache_path = MeshCachePath(obj_path);
+    Mesh cached;
+    MeshCacheHeader header;
+    if (LoadMeshCache(cache_path, cached, &header) && header.source.size == source.size) {
+        bool fresh = header.source.mtime == source.mtime;
+        if (!fresh) {
+            SourceStamp hashed;
+            fresh = StampSourceFile(obj_path, true, hashed) && hashed.hash == header.source.hash;
+
+            // Only the time changed, store it so later starts skip the hash again. Windows does not let the
+            // header be written in place while the cache is mapped, by this mesh or by a live one, so then
+            // the whole cache is written again through the temporary file
+            if (fresh && !WriteSourceTime(cache_path, source.mtime)) {
+                SourceStamp stamp = header.source;
+                stamp.mtime = source.mtime;
+                WriteMeshCache(cache_path, cached, stamp);
+            }
+        }
+        if (fresh) {
+            mesh = std::move(cached);
+            if (stats) {
+                stats->bytes = (size_t)header.file_size;
+                stats->vertices = mesh.positions.Size();
+                stats->triangles = mesh.TriangleCount();
+                stats->threads = 1;
+                stats->from_cache = true;
+                stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            }
+            return true;
+        }
+    }
+
+    // Parsing happens once per change of the OBJ, so this is where the mesh gets optimized and clustered
+    if (!LoadObj(obj_path, mesh, stats)) {
+        return false;
+    }
+    OptimizeMesh(mesh);
+    BuildMeshlets(mesh);
+    if (StampSourceFile(obj_path, true, source)) {
+        WriteMeshCache(cache_path, mesh, source);
+    }
+    return true;
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+struct Mesh;
+struct ObjLoadStats;
+
+/*
+ * Binary mesh cache, written next to an OBJ file as <name>.obj.meshcache and loaded without parsing or copying.
+ *
+ * Layout, native byte order, every block starts on a 64 byte boundary so it can be used in place:
+ *   MeshCacheHeader
+ *   positions  x[vertex_count], y[vertex_count], z[vertex_count]  (float)
+ *   indices    [triangle_count * 3]                                (uint32)
+ *   normals    x[triangle_count], y[triangle_count], z[triangle_count]  (float)
+ *   meshlets   [meshlet_count]                                     (Meshlet)
+ *   bvh        [bvh_node_count]                                    (BvhNode)
+ *
+ * The header remembers size, modification time and a hash of the OBJ it was built from. A cache whose
+ * size and time still match is used right away. When only the time moved (a checkout, a copy) the OBJ is
+ * hashed, and an unchanged hash keeps the cache. Anything else rebuilds it from the OBJ.
+ * A rebuilt mesh goes through OptimizeMesh and BuildMeshlets before it is written, so the cache holds the
+ * optimized order, the meshlets and their hierarchy.
+ */
+
+constexpr uint32_t MESH_CACHE_VERSION = 4;    // 2: meshes are stored after OptimizeMesh, 3: meshlets, 4: meshlet BVH
+
+/**
+ * @brief Identity of the source file a cache was built from.
+ */
+struct SourceStamp {
+    uint64_t size = 0;      // Bytes
+    int64_t mtime = 0;      // Last write time, in the ticks of std::filesystem::file_time_type
+    uint64_t hash = 0;      // HashBytes of the content, 0 if not computed
+};
+
+/**
+ * @brief The first bytes of a cache file.
+ */
+struct MeshCacheHeader {
+    char magic[8];              // "RMESHC\0\0"
+    uint32_t version;           // MESH_CACHE_VERSION
+    uint32_t byte_order;        // 0x01020304 as written by the machine that built it
+    uint64_t vertex_count;
+    uint64_t triangle_count;
+    uint64_t meshlet_count;
+    uint64_t bvh_node_count;
+    uint64_t positions_offset;  // Byte offsets of the blocks from the start of the file
+    uint64_t indices_offset;
+    uint64_t normals_offset;
+    uint64_t meshlets_offset;
+    uint64_t bvh_offset;
+    uint64_t file_size;         // Expected size of the whole cache file
+    float bounds_min[3];        // Object space bounding box
+    float bounds_max[3];
+    SourceStamp source;         // The OBJ this was built from
+};
+
+/**
+ * @brief A fast 64-bit hash of a block of memory (not cryptographic), used to tell whether a file changed.
+ * @param data The bytes
+ * @param size Number of bytes
+ * @return The hash
+ */
+uint64_t HashBytes(const void* data, size_t size);
+
+/**
+ * @brief Read size and time of a file, and optionally hash its content.
+ * @param path Path of the file
+ * @param with_hash Whether to read the whole file and fill in stamp.hash
+ * @param stamp Receives the stamp
+ * @return false if the file cannot be read
+ */
+bool StampSourceFile(const std::string& path, bool with_hash, SourceStamp& stamp);
+
+/**
+ * @brief Where the cache of a source file lives.
+ * @param source_path Path of the OBJ file
+ * @return The cache path
+ */
+std::string MeshCachePath(const std::string& source_path);
+
+/**
+ * @brief Write a mesh as a cache file. It is written to a temporary name and renamed, so a reader
+ * never sees a half written cache. A cache that cannot be replaced because it is still mapped (Windows)
+ * is renamed to <path>.old<n> first, and deleted by a later write once it is no longer mapped.
+ * @param path Path of the cache file
+ * @param mesh The mesh
+ * @param source Stamp of the file the mesh came from
+ * @return true if the cache was written
+ */
+bool WriteMeshCache(const std::string& path, const Mesh& mesh, const SourceStamp& source);
+
+/**
+ * @brief Map a cache file and point the mesh into it, nothing is copied. The file is only used if its layout
+ * matches its counts and every index, meshlet range and hierarchy node in it is in range.
+ * @param path Path of the cache file
+ * @param mesh Receives the mesh, it is left alone if the file is missing or not a valid cache
+ * @param header Receives the header, so the caller can compare the source stamp, may be nullptr
+ * @return true if the mesh now uses the cache
+ */
+bool LoadMeshCache(const std::string& path, Mesh& mesh, MeshCacheHeader* header = nullptr);
+
+/**
+ * @brief Load an OBJ file through its cache: use the cache while it matches the OBJ, otherwise parse
+ * and optimize the OBJ and write a new cache for the next start. Failing to write the cache is not an error.
+ * @param obj_path Path of the OBJ file
+ * @param mesh Receives the mesh
+ * @param stats Receives the timings, may be nullptr
+ * @return true if successfully loaded, otherwise false
+ */
+bool LoadObjCached(const std::string& obj_path, Mesh& mesh, ObjLoadStats* stats = nullptr);
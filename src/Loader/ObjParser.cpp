@@ -0,0 +1,284 @@
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include "ObjParser.h"
+#include "../Platform/MappedFile.h"
+#include "../Primitive/Mesh.h"
+
+namespace {
+
+// How much of the file EstimateObjCounts looks at
+constexpr size_t ESTIMATE_SAMPLE_BYTES = 256 * 1024;
+
+// Smallest stretch of text worth a thread of its own
+constexpr size_t MIN_CHUNK_BYTES = 4 * 1024 * 1024;
+
+/**
+ * @brief Run job(0) ... job(count - 1) on count threads, the calling thread takes job 0.
+ */
+template <typename Job>
+void RunParallel(size_t count, const Job& job) {
+    std::vector<std::thread> workers;
+    workers.reserve(count > 0 ? count - 1 : 0);
+    for (size_t i = 1; i < count; ++i) {
+        workers.emplace_back(job, i);
+    }
+    if (count > 0) {
+        job(0);
+    }
+    for (std::thread& t : workers) {
+        t.join();
+    }
+}
+
+inline bool IsBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline const char* SkipBlanks(const char* p, const char* end) {
+    while (p < end && IsBlank(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+inline const char* SkipToken(const char* p, const char* end) {
+    while (p < end && !IsBlank(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+/**
+ * @brief Read one float, std::from_chars does not take a leading '+' so it is skipped here.
+ * @return Position after the number, nullptr if there is no number
+ */
+inline const char* ReadFloat(const char* p, const char* end, float& value) {
+    p = SkipBlanks(p, end);
+    if (p < end && *p == '+') {
+        ++p;
+    }
+    std::from_chars_result res = std::from_chars(p, end, value);
+    return res.ec == std::errc() ? res.ptr : nullptr;
+}
+
+/**
+ * @brief Read the vertex part of one face corner (the 7 of 7/2/5) and skip the rest of it.
+ * @return Position after the corner, nullptr if there is no corner
+ */
+inline const char* ReadCorner(const char* p, const char* end, int32_t& value) {
+    std::from_chars_result res = std::from_chars(p, end, value);
+    if (res.ec != std::errc() || value == 0) {
+        return nullptr;
+    }
+    return SkipToken(res.ptr, end);
+}
+
+/**
+ * @brief Write the resolved indices of a chunk into the mesh index buffer.
+ * @param chunk The chunk
+ * @param vertex_base Number of vertices in the file before the chunk
+ * @param vertex_count Number of vertices in the whole file
+ * @param out Receives chunk.corners.size() indices
+ * @return false if a face refers to a vertex that does not exist
+ */
+bool ResolveCorners(ObjChunk& chunk, size_t vertex_base, size_t vertex_count, uint32_t* out) {
+    for (size_t r : chunk.relative) {
+        chunk.corners[r] += (int32_t)vertex_base;
+    }
+    for (size_t i = 0; i < chunk.corners.size(); ++i) {
+        int32_t c = chunk.corners[i];
+        if (c < 0 || (size_t)c >= vertex_count) {
+            std::cerr << "A face refers to vertex " << (int64_t)c + 1 << " of " << vertex_count << ".\n";
+            return false;
+        }
+        out[i] = (uint32_t)c;
+    }
+    return true;
+}
+
+}
+
+void EstimateObjCounts(const char* begin, const char* end, size_t& vertices, size_t& triangles) {
+    size_t size = (size_t)(end - begin);
+    const char* sample_end = begin + std::min(size, ESTIMATE_SAMPLE_BYTES);
+
+    size_t v_lines = 0, f_lines = 0;
+    for (const char* p = begin; p < sample_end;) {
+        if (p + 1 < sample_end && p[1] == ' ') {
+            v_lines += p[0] == 'v';
+            f_lines += p[0] == 'f';
+        }
+        const char* nl = static_cast<const char*>(std::memchr(p, '\n', (size_t)(sample_end - p)));
+        p = nl ? nl + 1 : sample_end;
+    }
+
+    // Scale up to the whole file with a little headroom, so the vectors grow at most once more
+    double scale = sample_end > begin ? 1.05 * (double)size / (double)(sample_end - begin) : 0.0;
+    vertices = (size_t)(v_lines * scale);
+    triangles = (size_t)(f_lines * scale);
+}
+
+void ParseObjChunk(const char* begin, const char* end, ObjChunk& out) {
+    VertexStreamSoA& pos = out.positions;
+    const char* p = begin;
+
+    while (p < end) {
+        const char* line_end = static_cast<const char*>(std::memchr(p, '\n', (size_t)(end - p)));
+        if (!line_end) {
+            line_end = end;
+        }
+
+        p = SkipBlanks(p, line_end);
+        if (p + 1 < line_end && IsBlank(p[1])) {
+            // If currently the line represent a vertex
+            if (p[0] == 'v') {
+                float x, y, z;
+                const char* q = p + 1;
+                if ((q = ReadFloat(q, line_end, x)) && (q = ReadFloat(q, line_end, y)) && (q = ReadFloat(q, line_end, z))) {
+                    pos.x.push_back(x);
+                    pos.y.push_back(y);
+                    pos.z.push_back(z);
+                }
+                else {
+                    ++out.bad_lines;
+                }
+            }
+            // If currently the line represent a face, split it into a fan around its first corner
+            else if (p[0] == 'f') {
+                int32_t fan[2] = {};        // First and previous corner
+                bool fan_relative[2] = {};
+                int32_t corner = 0;
+                int count = 0;
+                const char* q = SkipBlanks(p + 1, line_end);
+                while (q < line_end) {
+                    q = ReadCorner(q, line_end, corner);
+                    if (!q) {
+                        break;
+                    }
+
+                    // OBJ counts from 1, and negative indices count back from the latest vertex
+                    bool is_relative = corner < 0;
+                    int32_t index = is_relative ? (int32_t)pos.Size() + corner : corner - 1;
+
+                    if (count >= 2) {
+                        const int32_t tri[3] = { fan[0], fan[1], index };
+                        const bool tri_relative[3] = { fan_relative[0], fan_relative[1], is_relative };
+                        for (int i = 0; i < 3; ++i) {
+                            if (tri_relative[i]) {
+                                out.relative.push_back(out.corners.size());
+                            }
+                            out.corners.push_back(tri[i]);
+                        }
+                    }
+                    int slot = count == 0 ? 0 : 1;
+                    fan[slot] = index;
+                    fan_relative[slot] = is_relative;
+                    ++count;
+                    q = SkipBlanks(q, line_end);
+                }
+                if (!q || count < 3) {
+                    ++out.bad_lines;
+                }
+            }
+        }
+
+        p = line_end + 1;
+    }
+}
+
+bool LoadObj(const std::string& path, Mesh& mesh, ObjLoadStats* stats) {
+    auto start = std::chrono::steady_clock::now();
+
+    MappedFile file;
+    if (!file.Open(path)) {
+        return false;
+    }
+    const char* begin = file.Data();
+    const char* end = begin + file.Size();
+
+    size_t est_vertices = 0, est_triangles = 0;
+    EstimateObjCounts(begin, end, est_vertices, est_triangles);
+
+    // Cut the text into newline aligned chunks, one per thread, small files stay on one thread
+    size_t max_chunks = std::max<size_t>(1, std::thread::hardware_concurrency());
+    size_t chunk_count = std::min(max_chunks, std::max<size_t>(1, file.Size() / MIN_CHUNK_BYTES));
+    std::vector<const char*> cuts = { begin };
+    for (size_t c = 1; c < chunk_count; ++c) {
+        const char* cut = std::max(cuts.back(), begin + file.Size() / chunk_count * c);
+        const char* nl = static_cast<const char*>(std::memchr(cut, '\n', (size_t)(end - cut)));
+        if (!nl) {
+            break;
+        }
+        cuts.push_back(nl + 1);
+    }
+    cuts.push_back(end);
+    chunk_count = cuts.size() - 1;
+
+    // Parse every chunk on its own, each one reserves its share of the estimate
+    std::vector<ObjChunk> chunks(chunk_count);
+    RunParallel(chunk_count, [&](size_t c) {
+        double share = (double)(cuts[c + 1] - cuts[c]) / (double)std::max<size_t>(1, file.Size());
+        size_t chunk_vertices = (size_t)(est_vertices * share);
+        ObjChunk& chunk = chunks[c];
+        chunk.positions.x.reserve(chunk_vertices);
+        chunk.positions.y.reserve(chunk_vertices);
+        chunk.positions.z.reserve(chunk_vertices);
+        chunk.corners.reserve((size_t)(est_triangles * share) * 3);
+        ParseObjChunk(cuts[c], cuts[c + 1], chunk);
+    });
+
+    // Where each chunk lands in the merged buffers, in file order, so f lines resolve as in a serial parse
+    std::vector<size_t> vertex_base(chunk_count + 1, 0), index_base(chunk_count + 1, 0);
+    size_t bad_lines = 0;
+    for (size_t c = 0; c < chunk_count; ++c) {
+        vertex_base[c + 1] = vertex_base[c] + chunks[c].positions.Size();
+        index_base[c + 1] = index_base[c] + chunks[c].corners.size();
+        bad_lines += chunks[c].bad_lines;
+    }
+    if (bad_lines > 0) {
+        std::cerr << path << ": skipped " << bad_lines << " malformed v/f lines.\n";
+    }
+
+    const size_t vertex_count = vertex_base[chunk_count];
+    VertexStreamSoA positions;
+    std::vector<uint32_t> indices(index_base[chunk_count]);
+    if (chunk_count == 1) {
+        // Nothing to merge, keep the parsed arrays
+        positions = std::move(chunks[0].positions);
+    }
+    else {
+        positions.Resize(vertex_count);
+    }
+
+    std::vector<char> resolved(chunk_count, 0);
+    RunParallel(chunk_count, [&](size_t c) {
+        ObjChunk& chunk = chunks[c];
+        if (chunk_count > 1) {
+            std::copy(chunk.positions.x.begin(), chunk.positions.x.end(), positions.x.begin() + vertex_base[c]);
+            std::copy(chunk.positions.y.begin(), chunk.positions.y.end(), positions.y.begin() + vertex_base[c]);
+            std::copy(chunk.positions.z.begin(), chunk.positions.z.end(), positions.z.begin() + vertex_base[c]);
+            chunk.positions = {};
+        }
+        resolved[c] = ResolveCorners(chunk, vertex_base[c], vertex_count, indices.data() + index_base[c]);
+    });
+
+    if (std::find(resolved.begin(), resolved.end(), 0) != resolved.end()) {
+        std::cerr << "Cannot load " << path << ".\n";
+        return false;
+    }
+    mesh.SetGeometry(std::move(positions), std::move(indices));
+
+    if (stats) {
+        stats->bytes = file.Size();
+        stats->vertices = mesh.positions.Size();
+        stats->triangles = mesh.TriangleCount();
+        stats->threads = chunk_count;
+        stats->from_cache = false;
+        stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    return true;
+}
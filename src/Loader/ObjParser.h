@@ -0,0 +1,66 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../Maths/Matrix/TransformBatch.h"
+
+struct Mesh;
+
+/**
+ * @brief What loading an OBJ file cost, for the startup log.
+ */
+struct ObjLoadStats {
+    size_t bytes = 0;           // Size of the file
+    size_t vertices = 0;        // Vertices in the mesh
+    size_t triangles = 0;       // Triangles in the mesh, polygons count as a fan
+    size_t threads = 0;         // Chunks the text was parsed in, one thread each
+    bool from_cache = false;    // The mesh came from its binary cache, bytes is then the size of the cache
+    double seconds = 0.0;       // Wall clock time of the whole load
+
+    /**
+     * @return Parse throughput in MB/s (10^6 bytes)
+     */
+    double MegabytesPerSecond() const { return seconds > 0.0 ? (double)bytes / seconds * 1e-6 : 0.0; }
+};
+
+/**
+ * @brief The geometry of a stretch of OBJ text, before the face references are resolved.
+ */
+struct ObjChunk {
+    VertexStreamSoA positions;      // The v lines of the chunk, in file order
+    std::vector<int32_t> corners;   // Three per triangle, 0-based file wide vertex indices except for the ones in relative
+    std::vector<size_t> relative;   // Entries of corners that came from negative OBJ indices, they count from the
+                                    // first vertex of this chunk (and can be negative) until the chunk offset is known
+    size_t bad_lines = 0;           // v and f lines that could not be read
+};
+
+/**
+ * @brief Rough vertex and triangle counts of an OBJ text, taken from a sample at its start.
+ * @param begin Start of the text
+ * @param end End of the text
+ * @param vertices Receives the estimated vertex count
+ * @param triangles Receives the estimated triangle count
+ */
+void EstimateObjCounts(const char* begin, const char* end, size_t& vertices, size_t& triangles);
+
+/**
+ * @brief Parse the v and f lines of OBJ text in place, every other statement is skipped.
+ * Numbers are read with std::from_chars, lines can be of any length, polygons are split into a fan
+ * and the texture / normal parts of face corners (1/2/3, 1//3) are ignored.
+ * @param begin Start of the text, it should be the start of a line
+ * @param end End of the text
+ * @param out Receives the geometry, it is appended to
+ */
+void ParseObjChunk(const char* begin, const char* end, ObjChunk& out);
+
+/**
+ * @brief Load an OBJ file into an indexed mesh. The file is memory mapped and parsed in place.
+ * Large files are cut at line breaks into one chunk per core, the chunks are parsed in parallel and
+ * then concatenated in file order, so the result is the same as parsing the file in one go.
+ * @param path Path of the file
+ * @param mesh Receives the mesh, normals included
+ * @param stats Receives the timings, may be nullptr
+ * @return true if successfully loaded, otherwise false
+ */
+bool LoadObj(const std::string& path, Mesh& mesh, ObjLoadStats* stats = nullptr);
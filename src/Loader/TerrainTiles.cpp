@@ -0,0 +1,159 @@
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include "TerrainTiles.h"
+#include "MeshCache.h"
+#include "../Primitive/Mesh.h"
+#include "../Primitive/MeshLod.h"
+#include "../Primitive/MeshOptimizer.h"
+
+namespace {
+
+constexpr char MAGIC[8] = { 'R', 'T', 'I', 'L', 'E', 'S', 0, 0 };
+constexpr uint32_t NO_VERTEX = 0xFFFFFFFFu;
+
+/**
+ * @brief Size of a file, 0 if it cannot be read.
+ */
+uint64_t FileSize(const std::string& path) {
+    std::error_code ec;
+    uint64_t size = std::filesystem::file_size(path, ec);
+    return ec ? 0 : size;
+}
+
+}
+
+std::string TerrainTilePath(const std::string& index_path, uint32_t x, uint32_t z, bool coarse) {
+    return index_path + "." + std::to_string(x) + "_" + std::to_string(z) + (coarse ? ".coarse.meshcache" : ".meshcache");
+}
+
+bool BuildTerrainTiles(const Mesh& mesh, uint32_t tiles_x, uint32_t tiles_z, float coarse_ratio, const std::string& index_path) {
+    if (tiles_x == 0 || tiles_z == 0) {
+        std::cerr << "A terrain needs at least one tile.\n";
+        return false;
+    }
+
+    TerrainIndexHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = TERRAIN_TILES_VERSION;
+    header.tiles_x = tiles_x;
+    header.tiles_z = tiles_z;
+    header.origin[0] = mesh.bounds_min.x;
+    header.origin[1] = mesh.bounds_min.z;
+    header.tile_size[0] = std::max(mesh.bounds_max.x - mesh.bounds_min.x, 1e-6f) / (float)tiles_x;
+    header.tile_size[1] = std::max(mesh.bounds_max.z - mesh.bounds_min.z, 1e-6f) / (float)tiles_z;
+
+    // Bucket the triangles by the tile of their centroid, counting sort so each bucket keeps the mesh order
+    const size_t tri_count = mesh.TriangleCount();
+    const size_t tile_count = (size_t)tiles_x * tiles_z;
+    std::vector<uint32_t> tile_of(tri_count);
+    std::vector<size_t> tile_begin(tile_count + 1, 0);
+    for (size_t t = 0; t < tri_count; ++t) {
+        Vector3d c = (mesh.Corner(t, 0) + mesh.Corner(t, 1) + mesh.Corner(t, 2)) / 3.0f;
+        int tx = (int)((c.x - header.origin[0]) / header.tile_size[0]);
+        int tz = (int)((c.z - header.origin[1]) / header.tile_size[1]);
+        tx = std::min(std::max(tx, 0), (int)tiles_x - 1);
+        tz = std::min(std::max(tz, 0), (int)tiles_z - 1);
+        tile_of[t] = (uint32_t)tz * tiles_x + (uint32_t)tx;
+        ++tile_begin[tile_of[t] + 1];
+    }
+    for (size_t i = 0; i < tile_count; ++i) {
+        tile_begin[i + 1] += tile_begin[i];
+    }
+    std::vector<uint32_t> sorted(tri_count);
+    std::vector<size_t> fill(tile_begin.begin(), tile_begin.end() - 1);
+    for (size_t t = 0; t < tri_count; ++t) {
+        sorted[fill[tile_of[t]]++] = (uint32_t)t;
+    }
+
+    std::vector<TerrainTileInfo> infos(tile_count);
+    std::vector<uint32_t> remap(mesh.positions.Size(), NO_VERTEX);
+    bool ok = true;
+    for (uint32_t tz = 0; tz < tiles_z; ++tz) {
+        for (uint32_t tx = 0; tx < tiles_x; ++tx) {
+            const size_t tile = (size_t)tz * tiles_x + tx;
+            TerrainTileInfo& info = infos[tile];
+            if (tile_begin[tile] == tile_begin[tile + 1]) {
+                continue;
+            }
+
+            // Copy the vertices the tile uses, shared border vertices end up in both tiles
+            VertexStreamSoA positions;
+            std::vector<uint32_t> indices;
+            std::vector<uint32_t> used;
+            for (size_t k = tile_begin[tile]; k < tile_begin[tile + 1]; ++k) {
+                for (int c = 0; c < 3; ++c) {
+                    uint32_t v = mesh.indices[sorted[k] * 3 + c];
+                    if (remap[v] == NO_VERTEX) {
+                        remap[v] = (uint32_t)positions.Size();
+                        positions.PushBack(mesh.positions.Get(v));
+                        used.push_back(v);
+                    }
+                    indices.push_back(remap[v]);
+                }
+            }
+            for (uint32_t v : used) {
+                remap[v] = NO_VERTEX;
+            }
+
+            Mesh full;
+            full.SetGeometry(std::move(positions), std::move(indices));
+            OptimizeMesh(full);
+            BuildMeshlets(full);
+
+            // The cut edges are the boundary of the tile mesh, which the simplifier keeps in place
+            std::vector<Mesh> coarse;
+            std::vector<float> errors;
+            size_t target = std::max<size_t>((size_t)(full.TriangleCount() * coarse_ratio), 1);
+            SimplifyMesh(full, { target }, coarse, errors);
+
+            const std::string full_path = TerrainTilePath(index_path, tx, tz, false);
+            const std::string coarse_path = TerrainTilePath(index_path, tx, tz, true);
+            ok = WriteMeshCache(full_path, full, SourceStamp{}) && ok;
+            ok = WriteMeshCache(coarse_path, coarse[0], SourceStamp{}) && ok;
+
+            info.bounds_min[0] = full.bounds_min.x;
+            info.bounds_min[1] = full.bounds_min.y;
+            info.bounds_min[2] = full.bounds_min.z;
+            info.bounds_max[0] = full.bounds_max.x;
+            info.bounds_max[1] = full.bounds_max.y;
+            info.bounds_max[2] = full.bounds_max.z;
+            info.triangles = (uint32_t)full.TriangleCount();
+            info.coarse_triangles = (uint32_t)coarse[0].TriangleCount();
+            info.bytes = FileSize(full_path);
+            info.coarse_bytes = FileSize(coarse_path);
+        }
+    }
+
+    std::ofstream out(index_path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(infos.data()), (std::streamsize)(infos.size() * sizeof(TerrainTileInfo)));
+    if (!out) {
+        std::cerr << "Cannot write the terrain index " << index_path << ".\n";
+        return false;
+    }
+    return ok;
+}
+
+bool LoadTerrainIndex(const std::string& index_path, TerrainIndexHeader& header, std::vector<TerrainTileInfo>& tiles) {
+    std::ifstream in(index_path, std::ios::binary);
+    if (!in.is_open()) {
+        std::cerr << "The terrain index " << index_path << " cannot be opened.\n";
+        return false;
+    }
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!in || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != TERRAIN_TILES_VERSION ||
+        header.tiles_x == 0 || header.tiles_z == 0) {
+        std::cerr << index_path << " is not a valid terrain index.\n";
+        return false;
+    }
+    tiles.resize((size_t)header.tiles_x * header.tiles_z);
+    in.read(reinterpret_cast<char*>(tiles.data()), (std::streamsize)(tiles.size() * sizeof(TerrainTileInfo)));
+    if (!in) {
+        std::cerr << index_path << " is cut short.\n";
+        return false;
+    }
+    return true;
+}
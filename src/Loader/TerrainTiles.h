@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct Mesh;
+
+/*
+ * Terrain split into a grid of tiles on the XZ plane, for worlds that do not fit in memory as one mesh.
+ *
+ * An index file <name>.tiles describes the grid, and every tile that has triangles is stored next to it
+ * as two mesh caches (see MeshCache.h): <name>.tiles.<i>_<j>.meshcache with the full tile, and
+ * <name>.tiles.<i>_<j>.coarse.meshcache with a simplified copy that stands in while the full one is
+ * not loaded. Triangles belong to the tile that holds their centroid, so full tiles meet without gaps.
+ * Simplification never moves or removes a vertex on the border of a tile (see SimplifyMesh), so coarse
+ * tiles keep every border vertex of their full tile and meet full neighbours without gaps either.
+ */
+
+constexpr uint32_t TERRAIN_TILES_VERSION = 2;  // 2: coarse tiles keep every border vertex
+
+/**
+ * @brief The first bytes of an index file.
+ */
+struct TerrainIndexHeader {
+    char magic[8];              // "RTILES\0\0"
+    uint32_t version;           // TERRAIN_TILES_VERSION
+    uint32_t tiles_x;           // Grid size
+    uint32_t tiles_z;
+    float origin[2];            // x and z of the corner of tile (0, 0)
+    float tile_size[2];         // Size of a tile along x and z
+};
+
+/**
+ * @brief One tile as listed in the index, followed by tiles_x * tiles_z of these, row by row along x.
+ */
+struct TerrainTileInfo {
+    float bounds_min[3];        // Bounding box of the full tile
+    float bounds_max[3];
+    uint32_t triangles;         // Triangles in the full tile, 0 for an empty tile without files
+    uint32_t coarse_triangles;
+    uint64_t bytes;             // Size of the full cache file
+    uint64_t coarse_bytes;      // Size of the coarse cache file
+};
+
+/**
+ * @brief Where a tile is stored.
+ * @param index_path Path of the index file
+ * @param x Column of the tile
+ * @param z Row of the tile
+ * @param coarse The coarse copy rather than the full tile
+ * @return The path of the cache file
+ */
+std::string TerrainTilePath(const std::string& index_path, uint32_t x, uint32_t z, bool coarse);
+
+/**
+ * @brief Cut a mesh into tiles and write them with their index. Each tile is optimized and split into meshlets.
+ * The mesh itself can be a mapped cache, it is only read.
+ * @param mesh The whole terrain
+ * @param tiles_x Number of tiles along x
+ * @param tiles_z Number of tiles along z
+ * @param coarse_ratio Triangle count of a coarse tile relative to its full tile
+ * @param index_path Path of the index file to write
+ * @return true if every file was written
+ */
+bool BuildTerrainTiles(const Mesh& mesh, uint32_t tiles_x, uint32_t tiles_z, float coarse_ratio, const std::string& index_path);
+
+/**
+ * @brief Read an index file.
+ * @param index_path Path of the index file
+ * @param header Receives the header
+ * @param tiles Receives the tiles, row by row along x
+ * @return false if the file is missing or not a valid index
+ */
+bool LoadTerrainIndex(const std::string& index_path, TerrainIndexHeader& header, std::vector<TerrainTileInfo>& tiles);
@@ -0,0 +1,84 @@
+#include <algorithm>
+#include "Bvh.h"
+
+namespace {
+
+/**
+ * @brief Builds the nodes of one subtree after the other, depth first.
+ */
+class BvhBuilder {
+public:
+    BvhBuilder(const std::vector<BvhItem>& items, size_t leaf_size, std::vector<BvhNode>& nodes, std::vector<uint32_t>& order)
+        : items_(items), leaf_size_(std::max<size_t>(leaf_size, 1)), nodes_(nodes), order_(order) {}
+
+    /**
+     * @brief Fill in the node at index for the items order_[first .. first + count).
+     */
+    void Build(uint32_t index, uint32_t first, uint32_t count) {
+        BvhNode node{};
+        node.first = first;
+        node.count = count;
+        float center_min[3], center_max[3];
+        for (int a = 0; a < 3; ++a) {
+            node.bounds_min[a] = center_min[a] = 3.4e38f;
+            node.bounds_max[a] = center_max[a] = -3.4e38f;
+        }
+        for (uint32_t i = first; i < first + count; ++i) {
+            const BvhItem& item = items_[order_[i]];
+            for (int a = 0; a < 3; ++a) {
+                node.bounds_min[a] = std::min(node.bounds_min[a], item.bounds_min[a]);
+                node.bounds_max[a] = std::max(node.bounds_max[a], item.bounds_max[a]);
+                center_min[a] = std::min(center_min[a], Center(item, a));
+                center_max[a] = std::max(center_max[a], Center(item, a));
+            }
+        }
+
+        if (count <= leaf_size_) {
+            nodes_[index] = node;
+            return;
+        }
+
+        // Split at the median center along the axis where the centers spread the most
+        int axis = 0;
+        for (int a = 1; a < 3; ++a) {
+            if (center_max[a] - center_min[a] > center_max[axis] - center_min[axis]) {
+                axis = a;
+            }
+        }
+        uint32_t half = count / 2;
+        std::nth_element(order_.begin() + first, order_.begin() + first + half, order_.begin() + first + count,
+                         [&](uint32_t l, uint32_t r) { return Center(items_[l], axis) < Center(items_[r], axis); });
+
+        node.child = (uint32_t)nodes_.size();
+        nodes_[index] = node;
+        nodes_.resize(nodes_.size() + 2);
+        Build(node.child, first, half);
+        Build(node.child + 1, first + half, count - half);
+    }
+
+private:
+    static float Center(const BvhItem& item, int axis) {
+        return 0.5f * (item.bounds_min[axis] + item.bounds_max[axis]);
+    }
+
+    const std::vector<BvhItem>& items_;
+    size_t leaf_size_;
+    std::vector<BvhNode>& nodes_;
+    std::vector<uint32_t>& order_;
+};
+
+}
+
+void BuildBvh(const std::vector<BvhItem>& items, size_t leaf_size, std::vector<BvhNode>& nodes, std::vector<uint32_t>& order) {
+    nodes.clear();
+    order.resize(items.size());
+    for (size_t i = 0; i < items.size(); ++i) {
+        order[i] = (uint32_t)i;
+    }
+    if (items.empty()) {
+        return;
+    }
+    nodes.reserve(items.size() * 2);
+    nodes.resize(1);
+    BvhBuilder(items, leaf_size, nodes, order).Build(0, 0, (uint32_t)items.size());
+}
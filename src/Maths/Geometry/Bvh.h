@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Frustum.h"
+#include "../../Utils/Span.h"
+
+/**
+ * @brief A node of a bounding volume hierarchy. Every node covers a contiguous run of items in leaf order,
+ * so a node that is entirely inside the frustum hands over all its items at once without visiting its children.
+ * It is plain data so it can be written to and mapped from the mesh cache as it is.
+ */
+struct BvhNode {
+    float bounds_min[3];    // Box around every item below the node
+    float bounds_max[3];
+    uint32_t first;         // Items [first, first + count) in leaf order
+    uint32_t count;
+    uint32_t child;         // Index of the left child, the right one follows it, 0 for a leaf (the root is never a child)
+};
+
+/**
+ * @brief The box of one item to build a hierarchy over.
+ */
+struct BvhItem {
+    float bounds_min[3];
+    float bounds_max[3];
+};
+
+/**
+ * @brief Build a hierarchy by splitting the items at the median of their centers along the longest axis.
+ * The items are not moved, order tells in which order the leaves cover them, and node ranges index into order.
+ * @param items The boxes
+ * @param leaf_size Most items in a leaf
+ * @param nodes Receives the nodes, the root is nodes[0], empty if there are no items
+ * @param order Receives the item indices in leaf order
+ */
+void BuildBvh(const std::vector<BvhItem>& items, size_t leaf_size, std::vector<BvhNode>& nodes, std::vector<uint32_t>& order);
+
+/**
+ * @brief Walk the hierarchy against a frustum. Subtrees entirely outside are skipped, subtrees entirely
+ * inside and leaves that cross a plane are handed to visit, in leaf order.
+ * @param nodes The hierarchy
+ * @param frustum The frustum, in the space of the boxes
+ * @param reject Called as reject(node) for every node not outside the frustum, true skips its subtree
+ * (occlusion culling plugs in here)
+ * @param visit Called as visit(first, count, test) for the items [first, first + count) in leaf order,
+ * test is Inside when none of them needs clipping, Intersecting otherwise
+ */
+template <typename Reject, typename Visit>
+void CullBvh(Span<const BvhNode> nodes, const Frustum& frustum, Reject&& reject, Visit&& visit) {
+    if (nodes.Empty()) {
+        return;
+    }
+
+    // Median splits keep the depth near log2 of the item count, far below the stack size. Should a deeper
+    // hierarchy come in anyway, a node whose children no longer fit is handed over whole, as if it crossed a plane
+    constexpr int STACK_SIZE = 64;
+    uint32_t stack[STACK_SIZE];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const BvhNode& node = nodes[stack[--top]];
+        FrustumTest test = frustum.TestBox(node.bounds_min, node.bounds_max);
+        if (test == FrustumTest::Outside || reject(node)) {
+            continue;
+        }
+        if (test == FrustumTest::Inside || node.child == 0 || top + 2 > STACK_SIZE) {
+            visit(node.first, node.count, test);
+            continue;
+        }
+        stack[top++] = node.child + 1;
+        stack[top++] = node.child;
+    }
+}
+
+/**
+ * @brief Overloaded version with the frustum test only.
+ */
+template <typename Visit>
+void CullBvh(Span<const BvhNode> nodes, const Frustum& frustum, Visit&& visit) {
+    CullBvh(nodes, frustum, [](const BvhNode&) { return false; }, visit);
+}
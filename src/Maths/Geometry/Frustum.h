@@ -0,0 +1,113 @@
+#pragma once
+#include <cmath>
+#include "../Matrix/Mat4x4.h"
+
+/**
+ * @brief How a bounding volume lies relative to the frustum.
+ */
+enum class FrustumTest {
+    Outside,        // Entirely outside one of the planes, nothing of it can be seen
+    Intersecting,   // Crosses at least one plane, it may need clipping
+    Inside,         // Entirely inside all planes, no clipping needed
+};
+
+/**
+ * @brief The six planes of a view frustum, a point p is inside when a*x + b*y + c*z + d >= 0 for all of them.
+ * The planes are extracted from a matrix that takes points to clip space (Gribb and Hartmann), so they
+ * are in whatever space that matrix starts from: pass world * view * projection to get object space planes.
+ */
+struct Frustum {
+    float planes[6][4];   // left, right, bottom, top, near, far, normalized (a, b, c) so d is a distance
+
+    Frustum() = default;
+
+    /**
+     * @brief Extract the planes. The projection maps x and y to [-w, w] and z to [0, w], v' = v * M.
+     * @param m Matrix to clip space
+     * @param near_w The near plane is put at w = near_w instead of z = 0, to match ClipAgainstNearW
+     */
+    Frustum(const Mat4x4& m, float near_w) {
+        // Column c of the matrix gives clip component c as a plane equation
+        float col[4][4];
+        for (int c = 0; c < 4; ++c) {
+            for (int r = 0; r < 4; ++r) {
+                col[c][r] = m.m[r][c];
+            }
+        }
+        for (int r = 0; r < 4; ++r) {
+            planes[0][r] = col[3][r] + col[0][r];   // x >= -w
+            planes[1][r] = col[3][r] - col[0][r];   // x <= w
+            planes[2][r] = col[3][r] + col[1][r];   // y >= -w
+            planes[3][r] = col[3][r] - col[1][r];   // y <= w
+            planes[4][r] = col[3][r];               // w >= near_w
+            planes[5][r] = col[3][r] - col[2][r];   // z <= w
+        }
+        planes[4][3] -= near_w;
+
+        for (auto& p : planes) {
+            float len = std::sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+            if (len > 0.0f) {
+                for (float& v : p) {
+                    v /= len;
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Classify a sphere.
+     * @param x Center
+     * @param y
+     * @param z
+     * @param radius Radius
+     * @return Outside, Intersecting or Inside
+     */
+    FrustumTest TestSphere(float x, float y, float z, float radius) const {
+        FrustumTest res = FrustumTest::Inside;
+        for (const auto& p : planes) {
+            float dist = p[0] * x + p[1] * y + p[2] * z + p[3];
+            if (dist < -radius) {
+                return FrustumTest::Outside;
+            }
+            if (dist < radius) {
+                res = FrustumTest::Intersecting;
+            }
+        }
+        return res;
+    }
+
+    /**
+     * @brief Classify an axis aligned box.
+     * @param min Lower corner
+     * @param max Upper corner
+     * @return Outside, Intersecting or Inside
+     */
+    FrustumTest TestBox(const float min[3], const float max[3]) const {
+        FrustumTest res = FrustumTest::Inside;
+        for (const auto& p : planes) {
+            // The corner furthest along the plane normal, and the one furthest against it
+            float far_x = p[0] >= 0.0f ? max[0] : min[0], near_x = p[0] >= 0.0f ? min[0] : max[0];
+            float far_y = p[1] >= 0.0f ? max[1] : min[1], near_y = p[1] >= 0.0f ? min[1] : max[1];
+            float far_z = p[2] >= 0.0f ? max[2] : min[2], near_z = p[2] >= 0.0f ? min[2] : max[2];
+            if (p[0] * far_x + p[1] * far_y + p[2] * far_z + p[3] < 0.0f) {
+                return FrustumTest::Outside;
+            }
+            if (p[0] * near_x + p[1] * near_y + p[2] * near_z + p[3] < 0.0f) {
+                res = FrustumTest::Intersecting;
+            }
+        }
+        return res;
+    }
+
+    /**
+     * @brief Overloaded version taking the corners as vectors.
+     * @param min Lower corner
+     * @param max Upper corner
+     * @return Outside, Intersecting or Inside
+     */
+    FrustumTest TestBox(const Vector3d& min, const Vector3d& max) const {
+        const float lo[3] = { min.x, min.y, min.z };
+        const float hi[3] = { max.x, max.y, max.z };
+        return TestBox(lo, hi);
+    }
+};
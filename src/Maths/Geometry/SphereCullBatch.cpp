@@ -0,0 +1,138 @@
+#include "SphereCullBatch.h"
+#include "../Vector/Vec4.h"
+#include "../../Platform/CpuFeatures.h"
+
+#if defined(RASTERIZER_X86)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+using CullSpheresFunc = size_t (*)(const float*, const float*, const float*, float, size_t, const Frustum&, uint32_t*);
+
+/**
+ * @brief The scalar kernel, also used for the tail of the SIMD kernels.
+ */
+size_t CullSpheresScalar(const float* x, const float* y, const float* z, float radius, size_t begin, size_t end,
+                         const Frustum& frustum, uint32_t* visible) {
+    size_t n = 0;
+    for (size_t i = begin; i < end; ++i) {
+        bool outside = false;
+        for (const auto& p : frustum.planes) {
+            outside |= p[0] * x[i] + p[1] * y[i] + p[2] * z[i] + p[3] < -radius;
+        }
+        visible[n] = (uint32_t)i;
+        n += !outside;
+    }
+    return n;
+}
+
+size_t CullSpheresScalarAll(const float* x, const float* y, const float* z, float radius, size_t count,
+                            const Frustum& frustum, uint32_t* visible) {
+    return CullSpheresScalar(x, y, z, radius, 0, count, frustum, visible);
+}
+
+#if defined(RASTERIZER_VEC4_SSE)
+
+/**
+ * @brief 4 wide with SSE, every plane is a multiply-add chain and a compare, the indices are compacted without branches.
+ */
+size_t CullSpheresSse2(const float* x, const float* y, const float* z, float radius, size_t count,
+                       const Frustum& frustum, uint32_t* visible) {
+    __m128 planes[6][4];
+    for (int p = 0; p < 6; ++p) {
+        for (int c = 0; c < 4; ++c) {
+            planes[p][c] = _mm_set1_ps(frustum.planes[p][c]);
+        }
+    }
+    const __m128 neg_radius = _mm_set1_ps(-radius);
+
+    size_t n = 0;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 vx = _mm_loadu_ps(x + i);
+        __m128 vy = _mm_loadu_ps(y + i);
+        __m128 vz = _mm_loadu_ps(z + i);
+        __m128 outside = _mm_setzero_ps();
+        for (int p = 0; p < 6; ++p) {
+            __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, planes[p][0]), _mm_mul_ps(vy, planes[p][1])),
+                                     _mm_add_ps(_mm_mul_ps(vz, planes[p][2]), planes[p][3]));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(dist, neg_radius));
+        }
+        int keep = ~_mm_movemask_ps(outside);
+        for (int k = 0; k < 4; ++k) {
+            visible[n] = (uint32_t)(i + k);
+            n += (keep >> k) & 1;
+        }
+    }
+
+    // Scalar tail
+    return n + CullSpheresScalar(x, y, z, radius, i, count, frustum, visible + n);
+}
+
+#endif
+
+#if defined(RASTERIZER_X86)
+
+/**
+ * @brief 8 wide with AVX2 and FMA.
+ */
+RASTERIZER_TARGET_AVX2
+size_t CullSpheresAvx2(const float* x, const float* y, const float* z, float radius, size_t count,
+                       const Frustum& frustum, uint32_t* visible) {
+    __m256 planes[6][4];
+    for (int p = 0; p < 6; ++p) {
+        for (int c = 0; c < 4; ++c) {
+            planes[p][c] = _mm256_set1_ps(frustum.planes[p][c]);
+        }
+    }
+    const __m256 neg_radius = _mm256_set1_ps(-radius);
+
+    size_t n = 0;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 vx = _mm256_loadu_ps(x + i);
+        __m256 vy = _mm256_loadu_ps(y + i);
+        __m256 vz = _mm256_loadu_ps(z + i);
+        __m256 outside = _mm256_setzero_ps();
+        for (int p = 0; p < 6; ++p) {
+            __m256 dist = _mm256_fmadd_ps(vx, planes[p][0], _mm256_fmadd_ps(vy, planes[p][1], _mm256_fmadd_ps(vz, planes[p][2], planes[p][3])));
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(dist, neg_radius, _CMP_LT_OQ));
+        }
+        int keep = ~_mm256_movemask_ps(outside);
+        for (int k = 0; k < 8; ++k) {
+            visible[n] = (uint32_t)(i + k);
+            n += (keep >> k) & 1;
+        }
+    }
+
+    // Scalar tail
+    return n + CullSpheresScalar(x, y, z, radius, i, count, frustum, visible + n);
+}
+
+#endif
+
+/**
+ * @brief Pick the kernel for the active CPU tier, done once.
+ */
+CullSpheresFunc SelectCullSpheres() {
+    switch (ActiveCpuLevel()) {
+#if defined(RASTERIZER_X86)
+        case CpuLevel::Avx512:
+        case CpuLevel::Avx2:
+            return CullSpheresAvx2;
+#endif
+#if defined(RASTERIZER_VEC4_SSE)
+        case CpuLevel::Simd128: return CullSpheresSse2;
+#endif
+        default: return CullSpheresScalarAll;
+    }
+}
+
+}
+
+size_t CullSpheresSoA(const float* x, const float* y, const float* z, float radius, size_t count,
+                      const Frustum& frustum, uint32_t* visible) {
+    static const CullSpheresFunc kernel = SelectCullSpheres();
+    return kernel(x, y, z, radius, count, frustum, visible);
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "Frustum.h"
+
+/**
+ * @brief Test count spheres of the same radius, centers in structure-of-arrays layout, against a frustum.
+ * 8 spheres at a time with AVX2 or 4 with SSE depending on the CPU it runs on (see ActiveCpuLevel), the
+ * remainder runs in scalar code. A sphere is culled when it lies entirely behind one plane, as in Frustum::TestSphere.
+ * @param x The x coordinates of the centers
+ * @param y The y coordinates of the centers
+ * @param z The z coordinates of the centers
+ * @param radius The radius of every sphere
+ * @param count Number of spheres
+ * @param frustum The frustum, in the space of the centers
+ * @param visible Receives the indices of the spheres that are not culled, in order, room for count
+ * @return Number of indices written
+ */
+size_t CullSpheresSoA(const float* x, const float* y, const float* z, float radius, size_t count,
+                      const Frustum& frustum, uint32_t* visible);
@@ -0,0 +1,187 @@
+#pragma once
+#include <type_traits>
+#include <utility>
+#include "Vec.h"
+
+/*
+ * Matrices follow the same row-vector convention as the rest of the renderer: v' = v * M,
+ * so a chain A * B * C applies A first. A product of matrices is not evaluated where it is written,
+ * operator* returns a MatMul expression instead. When the expression is assigned to a Mat, every row
+ * of the result is pushed through the whole chain in one pass (row * A * B * C), no intermediate
+ * matrices are built, and when the inputs are constants the compiler folds the whole chain.
+ */
+
+template <int R, int C, typename T>
+struct Mat;
+
+/**
+ * @brief Base of everything that can stand on either side of a matrix product (CRTP).
+ */
+template <typename E>
+struct MatExpr {
+    constexpr const E& Self() const { return static_cast<const E&>(*this); }
+};
+
+/**
+ * @brief A generic R by C matrix, initialize with 0.
+ */
+template <int R, int C, typename T>
+struct Mat : MatExpr<Mat<R, C, T>> {
+    static constexpr int rows = R;
+    static constexpr int cols = C;
+    using value_type = T;
+
+    T m[R][C] = {};
+
+    constexpr Mat() = default;
+
+    /**
+     * @brief Evaluate a product expression into this matrix.
+     * @param e The expression, its dimensions must match
+     */
+    template <typename E>
+    constexpr Mat(const MatExpr<E>& e) {
+        static_assert(E::rows == R && E::cols == C, "Matrix expression has the wrong dimensions");
+        for (int r = 0; r < R; ++r) {
+            Vec<C, T> row = e.Self().Row(r);
+            for (int c = 0; c < C; ++c)
+                m[r][c] = row.v[c];
+        }
+    }
+
+    /**
+     * @brief Copy of one row.
+     * @param r Index of the row
+     * @return The row
+     */
+    constexpr Vec<C, T> Row(int r) const {
+        Vec<C, T> res;
+        for (int c = 0; c < C; ++c)
+            res.v[c] = m[r][c];
+        return res;
+    }
+};
+
+/* ---------------------------------
+ --------- Row x Expression --------
+ --------------------------------- */
+
+/**
+ * @brief Row vector times matrix.
+ * @param a The row vector
+ * @param b The matrix
+ * @return a * b
+ */
+template <int N, int C, typename T>
+constexpr Vec<C, T> operator*(const Vec<N, T>& a, const Mat<N, C, T>& b) {
+    Vec<C, T> res;
+    for (int c = 0; c < C; ++c) {
+        T s = T(0);
+        for (int k = 0; k < N; ++k)
+            s += a.v[k] * b.m[k][c];
+        res.v[c] = s;
+    }
+    return res;
+}
+
+/**
+ * @brief Whether a type is a matrix or a product expression.
+ */
+template <typename E>
+struct IsMatExpr : std::is_base_of<MatExpr<std::decay_t<E>>, std::decay_t<E>> {};
+
+/**
+ * @brief How a MatMul keeps an operand given as E (as deduced by a forwarding reference): named ones by
+ * reference, they outlive the expression, temporaries by value, so `auto m = a * MakeIdentity()` or a
+ * nested product kept in an auto never points at something already gone.
+ */
+template <typename E>
+using MatOperand = std::conditional_t<std::is_lvalue_reference<E>::value, const std::decay_t<E>&, std::decay_t<E>>;
+
+/**
+ * @brief The lazy product of two matrix expressions, L and Rhs are the operands as they are kept (see MatOperand).
+ */
+template <typename L, typename Rhs>
+struct MatMul : MatExpr<MatMul<L, Rhs>> {
+    static_assert(std::decay_t<L>::cols == std::decay_t<Rhs>::rows, "Matrix product dimensions do not match");
+    static constexpr int rows = std::decay_t<L>::rows;
+    static constexpr int cols = std::decay_t<Rhs>::cols;
+    using value_type = typename std::decay_t<L>::value_type;
+
+    L lhs;
+    Rhs rhs;
+
+    template <typename A, typename B>
+    constexpr MatMul(A&& l, B&& r) : lhs(std::forward<A>(l)), rhs(std::forward<B>(r)) {}
+
+    /**
+     * @brief Row r of the product, computed by pushing row r of the left side through the right side.
+     * @param r Index of the row
+     * @return The row
+     */
+    constexpr Vec<cols, value_type> Row(int r) const {
+        return lhs.Row(r) * rhs;
+    }
+};
+
+/**
+ * @brief Row vector times a product expression, (a * L) * R, which never builds L * R.
+ * @param a The row vector
+ * @param b The product
+ * @return a * b
+ */
+template <int N, typename T, typename L, typename Rhs>
+constexpr Vec<MatMul<L, Rhs>::cols, T> operator*(const Vec<N, T>& a, const MatMul<L, Rhs>& b) {
+    return (a * b.lhs) * b.rhs;
+}
+
+/**
+ * @brief Matrix product, returns an expression that is evaluated once assigned to a Mat.
+ * @param a Left side
+ * @param b Right side
+ * @return The lazy product a * b
+ */
+template <typename A, typename B, typename = std::enable_if_t<IsMatExpr<A>::value && IsMatExpr<B>::value>>
+constexpr MatMul<MatOperand<A>, MatOperand<B>> operator*(A&& a, B&& b) {
+    return MatMul<MatOperand<A>, MatOperand<B>>(std::forward<A>(a), std::forward<B>(b));
+}
+
+/**
+ * @brief Force the evaluation of an expression, handy with auto.
+ * @param e The expression
+ * @return The evaluated matrix
+ */
+template <typename E>
+constexpr Mat<E::rows, E::cols, typename E::value_type> Evaluate(const MatExpr<E>& e) {
+    return Mat<E::rows, E::cols, typename E::value_type>(e);
+}
+
+/* ---------------------------------
+ ------------ Builders -------------
+ --------------------------------- */
+
+/**
+ * @brief Make an identity matrix.
+ * @return The identity matrix
+ */
+template <int N, typename T>
+constexpr Mat<N, N, T> MakeIdentityMat() {
+    Mat<N, N, T> res;
+    for (int i = 0; i < N; ++i)
+        res.m[i][i] = T(1);
+    return res;
+}
+
+/**
+ * @brief Transpose of a matrix.
+ * @param a The matrix
+ * @return The transposed matrix
+ */
+template <int R, int C, typename T>
+constexpr Mat<C, R, T> Transpose(const Mat<R, C, T>& a) {
+    Mat<C, R, T> res;
+    for (int r = 0; r < R; ++r)
+        for (int c = 0; c < C; ++c)
+            res.m[c][r] = a.m[r][c];
+    return res;
+}
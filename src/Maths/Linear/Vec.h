@@ -0,0 +1,102 @@
+#pragma once
+#include <cmath>
+
+/**
+ * @brief A generic N component vector, float and double share the same code.
+ * Everything except the length (which needs a square root) is constexpr,
+ * so vectors built from constants are folded at compile time.
+ */
+template <int N, typename T>
+struct Vec {
+    T v[N] = {};
+
+    constexpr T& operator[](int i) { return v[i]; }
+    constexpr const T& operator[](int i) const { return v[i]; }
+};
+
+/* ---------------------------------
+ ------------ Operators ------------
+ --------------------------------- */
+
+template <int N, typename T>
+constexpr Vec<N, T> operator+(const Vec<N, T>& a, const Vec<N, T>& b) {
+    Vec<N, T> res;
+    for (int i = 0; i < N; ++i)
+        res.v[i] = a.v[i] + b.v[i];
+    return res;
+}
+
+template <int N, typename T>
+constexpr Vec<N, T> operator-(const Vec<N, T>& a, const Vec<N, T>& b) {
+    Vec<N, T> res;
+    for (int i = 0; i < N; ++i)
+        res.v[i] = a.v[i] - b.v[i];
+    return res;
+}
+
+template <int N, typename T>
+constexpr Vec<N, T> operator*(const Vec<N, T>& a, T s) {
+    Vec<N, T> res;
+    for (int i = 0; i < N; ++i)
+        res.v[i] = a.v[i] * s;
+    return res;
+}
+
+template <int N, typename T>
+constexpr Vec<N, T> operator/(const Vec<N, T>& a, T s) {
+    Vec<N, T> res;
+    for (int i = 0; i < N; ++i)
+        res.v[i] = a.v[i] / s;
+    return res;
+}
+
+/* -----------------------------
+ ----------- Utils -------------
+ ----------------------------- */
+
+/**
+ * @brief Dot product of two vectors.
+ * @param a One vector
+ * @param b The other vector
+ * @return The dot product
+ */
+template <int N, typename T>
+constexpr T Dot(const Vec<N, T>& a, const Vec<N, T>& b) {
+    T s = T(0);
+    for (int i = 0; i < N; ++i)
+        s += a.v[i] * b.v[i];
+    return s;
+}
+
+/**
+ * @brief Cross product, only defined for 3 component vectors.
+ * @param a One vector
+ * @param b The other vector
+ * @return a x b
+ */
+template <typename T>
+constexpr Vec<3, T> Cross(const Vec<3, T>& a, const Vec<3, T>& b) {
+    return { { a.v[1] * b.v[2] - a.v[2] * b.v[1],
+               a.v[2] * b.v[0] - a.v[0] * b.v[2],
+               a.v[0] * b.v[1] - a.v[1] * b.v[0] } };
+}
+
+/**
+ * @brief Length of a vector.
+ * @param a The vector
+ * @return The length
+ */
+template <int N, typename T>
+inline T Length(const Vec<N, T>& a) {
+    return std::sqrt(Dot(a, a));
+}
+
+/**
+ * @brief Unit vector in the direction of a, a must not be zero.
+ * @param a The vector
+ * @return The normalized vector
+ */
+template <int N, typename T>
+inline Vec<N, T> Normalized(const Vec<N, T>& a) {
+    return a / Length(a);
+}
@@ -1,16 +1,17 @@
 #pragma once
-
+#include <cmath>
 #include "../Vector/Vector3d.h"
+#include "../Linear/Mat.h"
 
 
 constexpr float PI = 3.14159f;
 
 /**
  * @brief A 4 by 4 matrix, initialize with 0.0f.
+ * This is the float instance of the generic Mat, so products of Mat4x4 are lazy expressions
+ * and a whole chain like rot_z * rot_x * trans is evaluated in one pass when assigned.
  */
-struct Mat4x4 {
-    float m[4][4] = { 0 };
-};
+using Mat4x4 = Mat<4, 4, float>;
 
 /* -------------------------------
  -------- Matrix & Vector --------
@@ -19,19 +20,42 @@ struct Mat4x4 {
 /**
  * @brief This method helps to do the matrix calculation with matrix and vector,
  * it uses pass-in by reference to save some space.
- * @param i The input vector.
+ * @param i The input vector, its w is taken as 1.
  * @param out The result vector.
  * @param matrix The matrix.
  */
-void MultiplyMatrixVector(Vector3d& i, Vector3d& out, Mat4x4& matrix);
+inline void MultiplyMatrixVector(const Vector3d& i, Vector3d& out, const Mat4x4& matrix) {
+    Vec4 res = Vec4Splat(i.x) * Vec4Load(matrix.m[0])
+             + Vec4Splat(i.y) * Vec4Load(matrix.m[1])
+             + Vec4Splat(i.z) * Vec4Load(matrix.m[2])
+             + Vec4Load(matrix.m[3]);
+    Vec4Store(&out.x, res);
+}
+
+/**
+ * @brief Multiply a direction by the matrix, the translation row is ignored (w is taken as 0).
+ * @param i The direction
+ * @param matrix The matrix
+ * @return The rotated direction, w = 1
+ */
+inline Vector3d RotateVector(const Vector3d& i, const Mat4x4& matrix) {
+    Vec4 res = Vec4Splat(i.x) * Vec4Load(matrix.m[0])
+             + Vec4Splat(i.y) * Vec4Load(matrix.m[1])
+             + Vec4Splat(i.z) * Vec4Load(matrix.m[2]);
+    return ToVector3d(res);
+}
 
-/** 
+/**
  * @brief Overloaded version of vec mat multiplication.
  * @param i The vector
  * @param matrix The matrix
  * @return The result vector
  */
-Vector3d MultiplyMatrixVector(Vector3d& i, Mat4x4& matrix);
+inline Vector3d MultiplyMatrixVector(const Vector3d& i, const Mat4x4& matrix) {
+    Vector3d res;
+    MultiplyMatrixVector(i, res, matrix);
+    return res;
+}
 
 /* ---------------------------------
  ------------ Identity -------------
@@ -41,32 +65,91 @@ Vector3d MultiplyMatrixVector(Vector3d& i, Mat4x4& matrix);
  * @brief Make a Identity matrix.
  * @return The identity matrix
  */
-Mat4x4 MakeIdentity();
+constexpr Mat4x4 MakeIdentity() {
+    return MakeIdentityMat<4, float>();
+}
 
 /* ---------------------------------
  ------------ Rotation -------------
  --------------------------------- */
 
+/**
+ * @brief Make a rotation on X-axis from an already known sine and cosine.
+ * @param s sin of the angle
+ * @param c cos of the angle
+ * @return The rotation matrix
+ */
+constexpr Mat4x4 MakeRotationX(float s, float c) {
+    Mat4x4 matrix;
+    matrix.m[0][0] = 1.0f;
+    matrix.m[1][1] = c;
+    matrix.m[1][2] = s;
+    matrix.m[2][1] = -s;
+    matrix.m[2][2] = c;
+    matrix.m[3][3] = 1.0f;
+    return matrix;
+}
+
+/**
+ * @brief Make a rotation on Y-axis from an already known sine and cosine.
+ * @param s sin of the angle
+ * @param c cos of the angle
+ * @return The rotation matrix
+ */
+constexpr Mat4x4 MakeRotationY(float s, float c) {
+    Mat4x4 matrix;
+    matrix.m[0][0] = c;
+    matrix.m[0][2] = s;
+    matrix.m[2][0] = -s;
+    matrix.m[1][1] = 1.0f;
+    matrix.m[2][2] = c;
+    matrix.m[3][3] = 1.0f;
+    return matrix;
+}
+
+/**
+ * @brief Make a rotation on Z-axis from an already known sine and cosine.
+ * @param s sin of the angle
+ * @param c cos of the angle
+ * @return The rotation matrix
+ */
+constexpr Mat4x4 MakeRotationZ(float s, float c) {
+    Mat4x4 matrix;
+    matrix.m[0][0] = c;
+    matrix.m[0][1] = s;
+    matrix.m[1][0] = -s;
+    matrix.m[1][1] = c;
+    matrix.m[2][2] = 1.0f;
+    matrix.m[3][3] = 1.0f;
+    return matrix;
+}
+
 /**
  * @brief Make a rotation on X-axis.
  * @param angleRad angle to rotate in radius
  * @return The rotation matrix
  */
-Mat4x4 MakeRotationX(float angleRad);
+inline Mat4x4 MakeRotationX(float angleRad) {
+    return MakeRotationX(std::sin(angleRad), std::cos(angleRad));
+}
 
 /**
  * @brief Make a rotation on Y-axis.
  * @param angleRad angle to rotate in radius
  * @return The rotation matrix
  */
-Mat4x4 MakeRotationY(float angleRad);
+inline Mat4x4 MakeRotationY(float angleRad) {
+    return MakeRotationY(std::sin(angleRad), std::cos(angleRad));
+}
 
 /**
  * @brief Make a rotation on Z-axis.
  * @param angleRad angle to rotate in radius
  * @return The rotation matrix
  */
-Mat4x4 MakeRotationZ(float angleRad);
+inline Mat4x4 MakeRotationZ(float angleRad) {
+    return MakeRotationZ(std::sin(angleRad), std::cos(angleRad));
+}
 
 /* ---------------------------------
  ---------- Translation ------------
@@ -79,7 +162,13 @@ Mat4x4 MakeRotationZ(float angleRad);
  * @param z Z coordinate that need to add
  * @return A translation matrix
  */
-Mat4x4 MakeTranslation(float x, float y, float z);
+constexpr Mat4x4 MakeTranslation(float x, float y, float z) {
+    Mat4x4 matrix = MakeIdentity();
+    matrix.m[3][0] = x;
+    matrix.m[3][1] = y;
+    matrix.m[3][2] = z;
+    return matrix;
+}
 
 /* -------------------------------
  ---------- Projection -----------
@@ -93,37 +182,95 @@ Mat4x4 MakeTranslation(float x, float y, float z);
  * @param far_plane The far plane of the frustum
  * @return The projection matrix
  */
-Mat4x4 MakeProjection(float fov_degrees, float aspect_ratio, float near_plane, float far_plane);
+inline Mat4x4 MakeProjection(float fov_degrees, float aspect_ratio, float near_plane, float far_plane) {
+    float fov_rad = 1.0f / std::tan(fov_degrees * 0.5f / 180.0f * PI);
+    Mat4x4 matrix;
+    matrix.m[0][0] = aspect_ratio * fov_rad;
+    matrix.m[1][1] = fov_rad;
+    matrix.m[2][2] = far_plane / (far_plane - near_plane);
+    matrix.m[3][2] = (-far_plane * near_plane) / (far_plane - near_plane);
+    matrix.m[2][3] = 1.0f;
+    matrix.m[3][3] = 0.0f;
+    return matrix;
+}
+
+/**
+ * @brief Construct the viewport matrix, it maps clip space to screen space in one step:
+ * after the divide by w, x and y are flipped, offset by 1 and scaled to half the screen size.
+ * @param width Screen width in pixels
+ * @param height Screen height in pixels
+ * @return The viewport matrix
+ */
+constexpr Mat4x4 MakeViewport(float width, float height) {
+    Mat4x4 matrix;
+    matrix.m[0][0] = -0.5f * width;
+    matrix.m[1][1] = -0.5f * height;
+    matrix.m[2][2] = 1.0f;
+    matrix.m[3][0] = 0.5f * width;
+    matrix.m[3][1] = 0.5f * height;
+    matrix.m[3][3] = 1.0f;
+    return matrix;
+}
 
 /* -------------------------------
  ---- Matrix Multiplication ------
  ------------------------------- */
 
 /**
- * @brief Matrix multiplication, this one has possible optimization
+ * @brief Matrix multiplication, evaluated right away. Prefer m1 * m2 * ... for chains.
  * @param m1 First matrix
  * @param m2 Second matrix
  * @return The result matrix
  */
-Mat4x4 MultiplyMatrix(Mat4x4& m1, Mat4x4& m2);
+constexpr Mat4x4 MultiplyMatrix(const Mat4x4& m1, const Mat4x4& m2) {
+    return m1 * m2;
+}
 
 /* ------------------------
  ---------- Utils ---------
  ------------------------ */
 
 /**
- * @brief Making a point-at matrix for converting world space into camera coordinates. 
+ * @brief Making a point-at matrix for converting world space into camera coordinates.
  * (This looks like setting up the camera coordinate/space)
  * @param pos The original position of the camera
  * @param target The look at target
  * @param up The helper up direction
  * @return The converting matrix
  */
-Mat4x4 PointAt(Vector3d& pos, Vector3d& target, Vector3d& up);
+inline Mat4x4 PointAt(const Vector3d& pos, const Vector3d& target, const Vector3d& up) {
+    // Calculate new forward direction, u
+    Vector3d u = NormalizeToNew(target - pos);
+
+    // Set up new up direction, v
+    Vector3d a = u * DotProduct(up, u);
+    Vector3d v = NormalizeToNew(up - a);
+
+    // New Right, w
+    Vector3d w = CrossProduct(v, u);
+
+    Mat4x4 matrix;
+    // NEED CHECK
+    matrix.m[0][0] = w.x; matrix.m[0][1] = w.y; matrix.m[0][2] = w.z; matrix.m[0][3] = 0.0f;
+    matrix.m[1][0] = v.x; matrix.m[1][1] = v.y; matrix.m[1][2] = v.z; matrix.m[1][3] = 0.0f;
+    matrix.m[2][0] = u.x; matrix.m[2][1] = u.y; matrix.m[2][2] = u.z; matrix.m[2][3] = 0.0f;
+    matrix.m[3][0] = pos.x; matrix.m[3][1] = pos.y; matrix.m[3][2] = pos.z; matrix.m[3][3] = 1.0f;
+    return matrix;
+}
 
 /**
  * @brief Inverse the given matrix. Only for 4x4 and rotation and translation
  * @param m The input matrix
  * @return A new matrix after inversed
  */
-Mat4x4 Inverse(Mat4x4& m);
\ No newline at end of file
+constexpr Mat4x4 Inverse(const Mat4x4& m) {
+    Mat4x4 matrix;
+    matrix.m[0][0] = m.m[0][0]; matrix.m[0][1] = m.m[1][0]; matrix.m[0][2] = m.m[2][0]; matrix.m[0][3] = 0.0f;
+    matrix.m[1][0] = m.m[0][1]; matrix.m[1][1] = m.m[1][1]; matrix.m[1][2] = m.m[2][1]; matrix.m[1][3] = 0.0f;
+    matrix.m[2][0] = m.m[0][2]; matrix.m[2][1] = m.m[1][2]; matrix.m[2][2] = m.m[2][2]; matrix.m[2][3] = 0.0f;
+    matrix.m[3][0] = -(m.m[3][0] * matrix.m[0][0] + m.m[3][1] * matrix.m[1][0] + m.m[3][2] * matrix.m[2][0]);
+    matrix.m[3][1] = -(m.m[3][0] * matrix.m[0][1] + m.m[3][1] * matrix.m[1][1] + m.m[3][2] * matrix.m[2][1]);
+    matrix.m[3][2] = -(m.m[3][0] * matrix.m[0][2] + m.m[3][1] * matrix.m[1][2] + m.m[3][2] * matrix.m[2][2]);
+    matrix.m[3][3] = 1.0f;
+    return matrix;
+}
@@ -0,0 +1,183 @@
+#include "TransformBatch.h"
+#include "../../Platform/CpuFeatures.h"
+
+#if defined(RASTERIZER_X86)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+using TransformPointsFunc = void (*)(const float*, const float*, const float*, float*, float*, float*, float*, size_t, const Mat4x4&);
+using TransformQuantizedFunc = void (*)(const uint16_t*, const uint16_t*, const uint16_t*, float*, float*, float*, float*, size_t, const Mat4x4&);
+
+/**
+ * @brief The scalar kernel, also used for the tail of the SIMD kernels. In is float or quantized uint16_t.
+ */
+template <typename In>
+void TransformPointsScalar(const In* in_x, const In* in_y, const In* in_z,
+                           float* out_x, float* out_y, float* out_z, float* out_w,
+                           size_t begin, size_t end, const Mat4x4& matrix) {
+    const float(*m)[4] = matrix.m;
+    for (size_t i = begin; i < end; ++i) {
+        float x = (float)in_x[i], y = (float)in_y[i], z = (float)in_z[i];
+        out_x[i] = x * m[0][0] + y * m[1][0] + z * m[2][0] + m[3][0];
+        out_y[i] = x * m[0][1] + y * m[1][1] + z * m[2][1] + m[3][1];
+        out_z[i] = x * m[0][2] + y * m[1][2] + z * m[2][2] + m[3][2];
+        out_w[i] = x * m[0][3] + y * m[1][3] + z * m[2][3] + m[3][3];
+    }
+}
+
+template <typename In>
+void TransformPointsScalarAll(const In* in_x, const In* in_y, const In* in_z,
+                              float* out_x, float* out_y, float* out_z, float* out_w,
+                              size_t count, const Mat4x4& matrix) {
+    TransformPointsScalar(in_x, in_y, in_z, out_x, out_y, out_z, out_w, 0, count, matrix);
+}
+
+// Loads of one register worth of inputs, quantized inputs are widened and converted on the way in
+inline Vec4 LoadLanes(const float* p) { return Vec4Load(p); }
+inline Vec4 LoadLanes(const uint16_t* p) { return Vec4LoadU16(p); }
+
+/**
+ * @brief 4 wide on Vec4, so SSE2 on x86 and NEON on ARM.
+ */
+template <typename In>
+void TransformPointsSimd128(const In* in_x, const In* in_y, const In* in_z,
+                            float* out_x, float* out_y, float* out_z, float* out_w,
+                            size_t count, const Mat4x4& matrix) {
+    Vec4 m[4][4];
+    for (int r = 0; r < 4; ++r)
+        for (int c = 0; c < 4; ++c)
+            m[r][c] = Vec4Splat(matrix.m[r][c]);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        Vec4 x = LoadLanes(in_x + i);
+        Vec4 y = LoadLanes(in_y + i);
+        Vec4 z = LoadLanes(in_z + i);
+        Vec4Store(out_x + i, x * m[0][0] + y * m[1][0] + z * m[2][0] + m[3][0]);
+        Vec4Store(out_y + i, x * m[0][1] + y * m[1][1] + z * m[2][1] + m[3][1]);
+        Vec4Store(out_z + i, x * m[0][2] + y * m[1][2] + z * m[2][2] + m[3][2]);
+        Vec4Store(out_w + i, x * m[0][3] + y * m[1][3] + z * m[2][3] + m[3][3]);
+    }
+
+    // Scalar tail
+    TransformPointsScalar(in_x, in_y, in_z, out_x, out_y, out_z, out_w, i, count, matrix);
+}
+
+#if defined(RASTERIZER_X86)
+
+RASTERIZER_TARGET_AVX2 inline __m256 LoadLanes8(const float* p) { return _mm256_loadu_ps(p); }
+RASTERIZER_TARGET_AVX2 inline __m256 LoadLanes8(const uint16_t* p) {
+    return _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))));
+}
+
+/**
+ * @brief 8 wide, every output column is a fused multiply-add chain of the three inputs and the translation row.
+ */
+template <typename In>
+RASTERIZER_TARGET_AVX2
+void TransformPointsAvx2(const In* in_x, const In* in_y, const In* in_z,
+                         float* out_x, float* out_y, float* out_z, float* out_w,
+                         size_t count, const Mat4x4& matrix) {
+    __m256 m[4][4];
+    for (int r = 0; r < 4; ++r)
+        for (int c = 0; c < 4; ++c)
+            m[r][c] = _mm256_set1_ps(matrix.m[r][c]);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 x = LoadLanes8(in_x + i);
+        __m256 y = LoadLanes8(in_y + i);
+        __m256 z = LoadLanes8(in_z + i);
+        _mm256_storeu_ps(out_x + i, _mm256_fmadd_ps(x, m[0][0], _mm256_fmadd_ps(y, m[1][0], _mm256_fmadd_ps(z, m[2][0], m[3][0]))));
+        _mm256_storeu_ps(out_y + i, _mm256_fmadd_ps(x, m[0][1], _mm256_fmadd_ps(y, m[1][1], _mm256_fmadd_ps(z, m[2][1], m[3][1]))));
+        _mm256_storeu_ps(out_z + i, _mm256_fmadd_ps(x, m[0][2], _mm256_fmadd_ps(y, m[1][2], _mm256_fmadd_ps(z, m[2][2], m[3][2]))));
+        _mm256_storeu_ps(out_w + i, _mm256_fmadd_ps(x, m[0][3], _mm256_fmadd_ps(y, m[1][3], _mm256_fmadd_ps(z, m[2][3], m[3][3]))));
+    }
+
+    // Scalar tail
+    TransformPointsScalar(in_x, in_y, in_z, out_x, out_y, out_z, out_w, i, count, matrix);
+}
+
+RASTERIZER_TARGET_AVX512 inline __m512 LoadLanes16(const float* p) { return _mm512_loadu_ps(p); }
+RASTERIZER_TARGET_AVX512 inline __m512 LoadLanes16(const uint16_t* p) {
+    // Zero masked forms with a full mask, the plain ones make GCC warn about its own undefined placeholder
+    __m512i wide = _mm512_maskz_cvtepu16_epi32((__mmask16)0xFFFF, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+    return _mm512_maskz_cvtepi32_ps((__mmask16)0xFFFF, wide);
+}
+
+/**
+ * @brief 16 wide, the same fused multiply-add chains as the AVX2 kernel.
+ */
+template <typename In>
+RASTERIZER_TARGET_AVX512
+void TransformPointsAvx512(const In* in_x, const In* in_y, const In* in_z,
+                           float* out_x, float* out_y, float* out_z, float* out_w,
+                           size_t count, const Mat4x4& matrix) {
+    __m512 m[4][4];
+    for (int r = 0; r < 4; ++r)
+        for (int c = 0; c < 4; ++c)
+            m[r][c] = _mm512_set1_ps(matrix.m[r][c]);
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512 x = LoadLanes16(in_x + i);
+        __m512 y = LoadLanes16(in_y + i);
+        __m512 z = LoadLanes16(in_z + i);
+        _mm512_storeu_ps(out_x + i, _mm512_fmadd_ps(x, m[0][0], _mm512_fmadd_ps(y, m[1][0], _mm512_fmadd_ps(z, m[2][0], m[3][0]))));
+        _mm512_storeu_ps(out_y + i, _mm512_fmadd_ps(x, m[0][1], _mm512_fmadd_ps(y, m[1][1], _mm512_fmadd_ps(z, m[2][1], m[3][1]))));
+        _mm512_storeu_ps(out_z + i, _mm512_fmadd_ps(x, m[0][2], _mm512_fmadd_ps(y, m[1][2], _mm512_fmadd_ps(z, m[2][2], m[3][2]))));
+        _mm512_storeu_ps(out_w + i, _mm512_fmadd_ps(x, m[0][3], _mm512_fmadd_ps(y, m[1][3], _mm512_fmadd_ps(z, m[2][3], m[3][3]))));
+    }
+
+    // Scalar tail
+    TransformPointsScalar(in_x, in_y, in_z, out_x, out_y, out_z, out_w, i, count, matrix);
+}
+
+#endif
+
+/**
+ * @brief Pick the kernel for the active CPU tier, done once per input type.
+ */
+template <typename In>
+auto SelectTransformPoints() -> void (*)(const In*, const In*, const In*, float*, float*, float*, float*, size_t, const Mat4x4&) {
+    switch (ActiveCpuLevel()) {
+#if defined(RASTERIZER_X86)
+        case CpuLevel::Avx512: return TransformPointsAvx512<In>;
+        case CpuLevel::Avx2: return TransformPointsAvx2<In>;
+#endif
+        case CpuLevel::Scalar: return TransformPointsScalarAll<In>;
+        default: return TransformPointsSimd128<In>;
+    }
+}
+
+}
+
+void TransformPointsSoA(const float* in_x, const float* in_y, const float* in_z,
+                        float* out_x, float* out_y, float* out_z, float* out_w,
+                        size_t count, const Mat4x4& matrix) {
+    static const TransformPointsFunc kernel = SelectTransformPoints<float>();
+    kernel(in_x, in_y, in_z, out_x, out_y, out_z, out_w, count, matrix);
+}
+
+void TransformPointsSoA(const VertexStreamView& in, HomogeneousStreamSoA& out, const Mat4x4& matrix) {
+    out.Resize(in.Size());
+    TransformPointsSoA(in.x.Data(), in.y.Data(), in.z.Data(),
+                       out.x.data(), out.y.data(), out.z.data(), out.w.data(),
+                       in.Size(), matrix);
+}
+
+void TransformQuantizedPointsSoA(const uint16_t* in_x, const uint16_t* in_y, const uint16_t* in_z,
+                                 float* out_x, float* out_y, float* out_z, float* out_w,
+                                 size_t count, const Mat4x4& matrix) {
+    static const TransformQuantizedFunc kernel = SelectTransformPoints<uint16_t>();
+    kernel(in_x, in_y, in_z, out_x, out_y, out_z, out_w, count, matrix);
+}
+
+void TransformQuantizedPointsSoA(const QuantizedStreamSoA& in, HomogeneousStreamSoA& out, const Mat4x4& matrix) {
+    out.Resize(in.Size());
+    TransformQuantizedPointsSoA(in.x.data(), in.y.data(), in.z.data(),
+                                out.x.data(), out.y.data(), out.z.data(), out.w.data(),
+                                in.Size(), matrix);
+}
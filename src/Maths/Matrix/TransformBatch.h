@@ -0,0 +1,197 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Mat4x4.h"
+#include "../../Utils/Span.h"
+
+/**
+ * @brief Vertex positions stored as structure-of-arrays, one array per axis.
+ * This is the layout the batch kernels stream through, 8 (AVX2) or 4 (SSE) vertices at a time.
+ */
+struct VertexStreamSoA {
+    std::vector<float> x, y, z;
+
+    /**
+     * @brief Number of vertices in the stream.
+     * @return The vertex count
+     */
+    size_t Size() const { return x.size(); }
+
+    /**
+     * @brief Resize all three arrays.
+     * @param count The new vertex count
+     */
+    void Resize(size_t count) {
+        x.resize(count);
+        y.resize(count);
+        z.resize(count);
+    }
+
+    /**
+     * @brief Append a vertex, w is dropped.
+     * @param vec The vertex
+     */
+    void PushBack(const Vector3d& vec) {
+        x.push_back(vec.x);
+        y.push_back(vec.y);
+        z.push_back(vec.z);
+    }
+
+    /**
+     * @brief Read back one vertex as a Vector3d.
+     * @param i Index of the vertex
+     * @return The vertex, with w = 1
+     */
+    Vector3d Get(size_t i) const { return { x[i], y[i], z[i] }; }
+};
+
+/**
+ * @brief Read-only view of vertex positions in structure-of-arrays layout.
+ * It does not own the arrays, they live in a VertexStreamSoA or in a mapped mesh file.
+ */
+struct VertexStreamView {
+    Span<const float> x, y, z;
+
+    VertexStreamView() = default;
+    VertexStreamView(Span<const float> new_x, Span<const float> new_y, Span<const float> new_z) : x(new_x), y(new_y), z(new_z) {}
+    VertexStreamView(const VertexStreamSoA& stream) : x(stream.x), y(stream.y), z(stream.z) {}
+
+    /**
+     * @brief Number of vertices in the stream.
+     * @return The vertex count
+     */
+    size_t Size() const { return x.Size(); }
+
+    /**
+     * @brief Read back one vertex as a Vector3d.
+     * @param i Index of the vertex
+     * @return The vertex, with w = 1
+     */
+    Vector3d Get(size_t i) const { return { x[i], y[i], z[i] }; }
+};
+
+/**
+ * @brief Vertex positions quantized to 16 bits per axis, structure-of-arrays like VertexStreamSoA.
+ * The integers only mean something together with the box they were quantized in, see QuantizedMesh.
+ */
+struct QuantizedStreamSoA {
+    std::vector<uint16_t> x, y, z;
+
+    /**
+     * @brief Number of vertices in the stream.
+     * @return The vertex count
+     */
+    size_t Size() const { return x.size(); }
+
+    /**
+     * @brief Resize all three arrays.
+     * @param count The new vertex count
+     */
+    void Resize(size_t count) {
+        x.resize(count);
+        y.resize(count);
+        z.resize(count);
+    }
+
+    /**
+     * @brief Append a vertex.
+     * @param qx Quantized x
+     * @param qy Quantized y
+     * @param qz Quantized z
+     */
+    void PushBack(uint16_t qx, uint16_t qy, uint16_t qz) {
+        x.push_back(qx);
+        y.push_back(qy);
+        z.push_back(qz);
+    }
+};
+
+/**
+ * @brief Transformed vertex positions in structure-of-arrays layout, w is kept for the perspective divide.
+ */
+struct HomogeneousStreamSoA {
+    std::vector<float> x, y, z, w;
+
+    /**
+     * @brief Number of vertices in the stream.
+     * @return The vertex count
+     */
+    size_t Size() const { return x.size(); }
+
+    /**
+     * @brief Resize all four arrays.
+     * @param count The new vertex count
+     */
+    void Resize(size_t count) {
+        x.resize(count);
+        y.resize(count);
+        z.resize(count);
+        w.resize(count);
+    }
+
+    /**
+     * @brief Read back one vertex as a Vector3d.
+     * @param i Index of the vertex
+     * @return The vertex including its w
+     */
+    Vector3d Get(size_t i) const {
+        Vector3d res{ x[i], y[i], z[i] };
+        res.w = w[i];
+        return res;
+    }
+};
+
+/**
+ * @brief Transform count vertices by one matrix, same math as MultiplyMatrixVector (input w is taken as 1).
+ * The kernel is picked once for the CPU it runs on (see ActiveCpuLevel): 16 wide AVX-512, 8 wide AVX2,
+ * 4 wide SSE2/NEON or scalar, the remainder is always finished in scalar code.
+ * Input and output arrays must not overlap.
+ * @param in_x Input x coordinates
+ * @param in_y Input y coordinates
+ * @param in_z Input z coordinates
+ * @param out_x Output x coordinates
+ * @param out_y Output y coordinates
+ * @param out_z Output z coordinates
+ * @param out_w Output w coordinates
+ * @param count Number of vertices
+ * @param matrix The matrix
+ */
+void TransformPointsSoA(const float* in_x, const float* in_y, const float* in_z,
+                        float* out_x, float* out_y, float* out_z, float* out_w,
+                        size_t count, const Mat4x4& matrix);
+
+/**
+ * @brief Overloaded version working on whole streams, out is resized to match in.
+ * @param in The input vertices
+ * @param out The transformed vertices
+ * @param matrix The matrix
+ */
+void TransformPointsSoA(const VertexStreamView& in, HomogeneousStreamSoA& out, const Mat4x4& matrix);
+
+/**
+ * @brief Transform quantized vertices, the integers are converted to float in registers and go straight into
+ * the same multiply-add chains as TransformPointsSoA, so no float copy of the positions is ever written.
+ * The dequantization (q * scale + offset) is linear, fold it into the matrix first (see QuantizedMesh::Dequantization).
+ * Dispatched like TransformPointsSoA.
+ * @param in_x Input x, quantized
+ * @param in_y Input y, quantized
+ * @param in_z Input z, quantized
+ * @param out_x Output x coordinates
+ * @param out_y Output y coordinates
+ * @param out_z Output z coordinates
+ * @param out_w Output w coordinates
+ * @param count Number of vertices
+ * @param matrix Dequantization followed by the transform
+ */
+void TransformQuantizedPointsSoA(const uint16_t* in_x, const uint16_t* in_y, const uint16_t* in_z,
+                                 float* out_x, float* out_y, float* out_z, float* out_w,
+                                 size_t count, const Mat4x4& matrix);
+
+/**
+ * @brief Overloaded version working on whole streams, out is resized to match in.
+ * @param in The quantized vertices
+ * @param out The transformed vertices
+ * @param matrix Dequantization followed by the transform
+ */
+void TransformQuantizedPointsSoA(const QuantizedStreamSoA& in, HomogeneousStreamSoA& out, const Mat4x4& matrix);
@@ -0,0 +1,103 @@
+#pragma once
+#include <cmath>
+#include "../Vector/Vector3d.h"
+#include "../Matrix/Mat4x4.h"
+
+/**
+ * @brief A rotation stored as a unit quaternion, (x, y, z) is the vector part and w the scalar part.
+ * Initialize as the identity rotation.
+ */
+struct Quaternion {
+    float x = 0.0f, y = 0.0f, z = 0.0f, w = 1.0f;
+};
+
+/* ---------------------------------
+ ---------- Construction -----------
+ --------------------------------- */
+
+/**
+ * @brief Sine and cosine of the same angle, written so the compiler can merge them into one sincos call.
+ * @param angleRad The angle in radius
+ * @param s Receives the sine
+ * @param c Receives the cosine
+ */
+inline void SinCos(float angleRad, float& s, float& c) {
+    s = std::sin(angleRad);
+    c = std::cos(angleRad);
+}
+
+/**
+ * @brief Make a rotation around an axis (right handed). This matches MakeRotationX and MakeRotationZ,
+ * MakeRotationY turns the other way so pass -angleRad to reproduce it.
+ * @param axis The rotation axis, must be unit length
+ * @param angleRad angle to rotate in radius
+ * @return The rotation
+ */
+inline Quaternion QuaternionFromAxisAngle(const Vector3d& axis, float angleRad) {
+    float s, c;
+    SinCos(angleRad * 0.5f, s, c);
+    return { axis.x * s, axis.y * s, axis.z * s, c };
+}
+
+/* ---------------------------------
+ ----------- Composition -----------
+ --------------------------------- */
+
+/**
+ * @brief Compose two rotations in the same order as Mat4x4 products: a * b rotates by a first, then by b.
+ * @param a The first rotation
+ * @param b The second rotation
+ * @return The combined rotation
+ */
+inline Quaternion operator*(const Quaternion& a, const Quaternion& b) {
+    // Hamilton product b (x) a, since vectors are rows and the first rotation sits on the left
+    return { b.w * a.x + b.x * a.w + b.y * a.z - b.z * a.y,
+             b.w * a.y - b.x * a.z + b.y * a.w + b.z * a.x,
+             b.w * a.z + b.x * a.y - b.y * a.x + b.z * a.w,
+             b.w * a.w - b.x * a.x - b.y * a.y - b.z * a.z };
+}
+
+/**
+ * @brief Renormalize a quaternion, use it now and then when composing many small rotations.
+ * @param q The quaternion
+ * @return The unit quaternion
+ */
+inline Quaternion NormalizeQuaternion(const Quaternion& q) {
+    float l = std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+    return { q.x / l, q.y / l, q.z / l, q.w / l };
+}
+
+/* ---------------------------------
+ ----------- Conversion ------------
+ --------------------------------- */
+
+/**
+ * @brief Build the rotation matrix, no trigonometry involved.
+ * @param q The rotation, must be unit length
+ * @return The rotation matrix, laid out for row vectors like the rest of Mat4x4
+ */
+inline Mat4x4 QuaternionToMatrix(const Quaternion& q) {
+    float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+    float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+    float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+    Mat4x4 matrix;
+    matrix.m[0][0] = 1.0f - 2.0f * (yy + zz); matrix.m[0][1] = 2.0f * (xy + wz);        matrix.m[0][2] = 2.0f * (xz - wy);
+    matrix.m[1][0] = 2.0f * (xy - wz);        matrix.m[1][1] = 1.0f - 2.0f * (xx + zz); matrix.m[1][2] = 2.0f * (yz + wx);
+    matrix.m[2][0] = 2.0f * (xz + wy);        matrix.m[2][1] = 2.0f * (yz - wx);        matrix.m[2][2] = 1.0f - 2.0f * (xx + yy);
+    matrix.m[3][3] = 1.0f;
+    return matrix;
+}
+
+/**
+ * @brief Rotate a vector without building a matrix.
+ * @param q The rotation, must be unit length
+ * @param v The vector
+ * @return The rotated vector
+ */
+inline Vector3d RotateByQuaternion(const Quaternion& q, const Vector3d& v) {
+    // v' = v + 2w (u x v) + 2 u x (u x v), with u the vector part
+    Vector3d u{ q.x, q.y, q.z };
+    Vector3d t = CrossProduct(u, v) * 2.0f;
+    return v + t * q.w + CrossProduct(u, t);
+}
@@ -0,0 +1,129 @@
+#include <cfloat>
+#include <cmath>
+#include "NormalizeBatch.h"
+#include "Vec4.h"
+#include "../../Platform/CpuFeatures.h"
+
+#if defined(RASTERIZER_X86)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+using NormalizeFunc = void (*)(float*, float*, float*, size_t);
+
+// Vectors with a squared length at or below MIN_LENGTH2 or above MAX_LENGTH2 become zero. Below the first
+// rsqrt of a denormal is inf, past the second len2 is inf and the Newton step gives NaN, so every kernel
+// uses the same cuts to give the same result
+constexpr float MIN_LENGTH2 = FLT_MIN;
+constexpr float MAX_LENGTH2 = FLT_MAX;
+
+/**
+ * @brief The scalar kernel, also used for the tail of the SIMD kernels.
+ */
+void NormalizeScalar(float* x, float* y, float* z, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        float len2 = x[i] * x[i] + y[i] * y[i] + z[i] * z[i];
+        float r = len2 > MIN_LENGTH2 && len2 <= MAX_LENGTH2 ? 1.0f / std::sqrt(len2) : 0.0f;
+        x[i] *= r;
+        y[i] *= r;
+        z[i] *= r;
+    }
+}
+
+void NormalizeScalarAll(float* x, float* y, float* z, size_t count) {
+    NormalizeScalar(x, y, z, 0, count);
+}
+
+#if defined(RASTERIZER_VEC4_SSE)
+
+/**
+ * @brief 4 wide with SSE.
+ */
+void NormalizeSse2(float* x, float* y, float* z, size_t count) {
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 three = _mm_set1_ps(3.0f);
+    const __m128 min_len2 = _mm_set1_ps(MIN_LENGTH2);
+    const __m128 max_len2 = _mm_set1_ps(MAX_LENGTH2);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 vx = _mm_loadu_ps(x + i);
+        __m128 vy = _mm_loadu_ps(y + i);
+        __m128 vz = _mm_loadu_ps(z + i);
+        __m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+
+        // r = r * (3 - len2 * r * r) / 2
+        __m128 r = _mm_rsqrt_ps(len2);
+        r = _mm_mul_ps(_mm_mul_ps(half, r), _mm_sub_ps(three, _mm_mul_ps(_mm_mul_ps(len2, r), r)));
+        r = _mm_and_ps(r, _mm_and_ps(_mm_cmpgt_ps(len2, min_len2), _mm_cmple_ps(len2, max_len2)));
+
+        _mm_storeu_ps(x + i, _mm_mul_ps(vx, r));
+        _mm_storeu_ps(y + i, _mm_mul_ps(vy, r));
+        _mm_storeu_ps(z + i, _mm_mul_ps(vz, r));
+    }
+
+    // Scalar tail
+    NormalizeScalar(x, y, z, i, count);
+}
+
+#endif
+
+#if defined(RASTERIZER_X86)
+
+/**
+ * @brief 8 wide with AVX2 and FMA.
+ */
+RASTERIZER_TARGET_AVX2
+void NormalizeAvx2(float* x, float* y, float* z, size_t count) {
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 three = _mm256_set1_ps(3.0f);
+    const __m256 min_len2 = _mm256_set1_ps(MIN_LENGTH2);
+    const __m256 max_len2 = _mm256_set1_ps(MAX_LENGTH2);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 vx = _mm256_loadu_ps(x + i);
+        __m256 vy = _mm256_loadu_ps(y + i);
+        __m256 vz = _mm256_loadu_ps(z + i);
+        __m256 len2 = _mm256_fmadd_ps(vx, vx, _mm256_fmadd_ps(vy, vy, _mm256_mul_ps(vz, vz)));
+
+        // r = r * (3 - len2 * r * r) / 2
+        __m256 r = _mm256_rsqrt_ps(len2);
+        r = _mm256_mul_ps(_mm256_mul_ps(half, r), _mm256_fnmadd_ps(_mm256_mul_ps(len2, r), r, three));
+        r = _mm256_and_ps(r, _mm256_and_ps(_mm256_cmp_ps(len2, min_len2, _CMP_GT_OQ), _mm256_cmp_ps(len2, max_len2, _CMP_LE_OQ)));
+
+        _mm256_storeu_ps(x + i, _mm256_mul_ps(vx, r));
+        _mm256_storeu_ps(y + i, _mm256_mul_ps(vy, r));
+        _mm256_storeu_ps(z + i, _mm256_mul_ps(vz, r));
+    }
+
+    // Scalar tail
+    NormalizeScalar(x, y, z, i, count);
+}
+
+#endif
+
+/**
+ * @brief Pick the kernel for the active CPU tier, done once.
+ */
+NormalizeFunc SelectNormalize() {
+    switch (ActiveCpuLevel()) {
+#if defined(RASTERIZER_X86)
+        case CpuLevel::Avx512:
+        case CpuLevel::Avx2:
+            return NormalizeAvx2;
+#endif
+#if defined(RASTERIZER_VEC4_SSE)
+        case CpuLevel::Simd128: return NormalizeSse2;
+#endif
+        default: return NormalizeScalarAll;
+    }
+}
+
+}
+
+void NormalizeSoA(float* x, float* y, float* z, size_t count) {
+    static const NormalizeFunc kernel = SelectNormalize();
+    kernel(x, y, z, count);
+}
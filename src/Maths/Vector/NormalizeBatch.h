@@ -0,0 +1,15 @@
+#pragma once
+#include <cstddef>
+
+/**
+ * @brief Normalize count vectors held in structure-of-arrays layout, in place.
+ * Uses a reciprocal square root estimate refined by one Newton-Raphson step, 8 wide with AVX2 or 4 wide with SSE
+ * depending on the CPU it runs on (see ActiveCpuLevel); the remainder runs in scalar code. Zero vectors, and
+ * vectors so short their squared length is below FLT_MIN, come out as zero on every path,
+ * as do vectors so long their squared length overflows.
+ * @param x The x coordinates
+ * @param y The y coordinates
+ * @param z The z coordinates
+ * @param count Number of vectors
+ */
+void NormalizeSoA(float* x, float* y, float* z, size_t count);
@@ -0,0 +1,235 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+
+// Pick the widest 4-lane float unit we can rely on at compile time. x64 always has SSE2,
+// 32-bit MSVC only when built with /arch:SSE2 or above, ARM64 always has NEON.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RASTERIZER_VEC4_SSE 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define RASTERIZER_VEC4_NEON 1
+#include <arm_neon.h>
+#endif
+
+/**
+ * @brief A 4-lane float register, backed by SSE or NEON when available and by plain floats otherwise.
+ * It is small enough to be passed by value everywhere, which lets the compiler keep it in a register.
+ */
+struct alignas(16) Vec4 {
+#if defined(RASTERIZER_VEC4_SSE)
+    __m128 v;
+#elif defined(RASTERIZER_VEC4_NEON)
+    float32x4_t v;
+#else
+    float v[4];
+#endif
+};
+
+/* ---------------------------------
+ ---------- Load & Store -----------
+ --------------------------------- */
+
+/**
+ * @brief Load four floats, the pointer does not have to be 16-byte aligned.
+ * @param p Pointer to four consecutive floats
+ * @return The loaded register
+ */
+inline Vec4 Vec4Load(const float* p) {
+#if defined(RASTERIZER_VEC4_SSE)
+    return { _mm_loadu_ps(p) };
+#elif defined(RASTERIZER_VEC4_NEON)
+    return { vld1q_f32(p) };
+#else
+    return { { p[0], p[1], p[2], p[3] } };
+#endif
+}
+
+/**
+ * @brief Store four floats, the pointer does not have to be 16-byte aligned.
+ * @param p Pointer to storage for four floats
+ * @param a The register to store
+ */
+inline void Vec4Store(float* p, Vec4 a) {
+#if defined(RASTERIZER_VEC4_SSE)
+    _mm_storeu_ps(p, a.v);
+#elif defined(RASTERIZER_VEC4_NEON)
+    vst1q_f32(p, a.v);
+#else
+    p[0] = a.v[0]; p[1] = a.v[1]; p[2] = a.v[2]; p[3] = a.v[3];
+#endif
+}
+
+/**
+ * @brief Load four 16-bit unsigned integers and convert them to floats, the pointer does not have to be aligned.
+ * @param p Pointer to four consecutive uint16_t
+ * @return The register { p[0], p[1], p[2], p[3] } as floats
+ */
+inline Vec4 Vec4LoadU16(const uint16_t* p) {
+#if defined(RASTERIZER_VEC4_SSE)
+    __m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+    return { _mm_cvtepi32_ps(_mm_unpacklo_epi16(packed, _mm_setzero_si128())) };
+#elif defined(RASTERIZER_VEC4_NEON)
+    return { vcvtq_f32_u32(vmovl_u16(vld1_u16(p))) };
+#else
+    return { { (float)p[0], (float)p[1], (float)p[2], (float)p[3] } };
+#endif
+}
+
+/**
+ * @brief Build a register from four lanes.
+ * @return The register { x, y, z, w }
+ */
+inline Vec4 Vec4Set(float x, float y, float z, float w) {
+#if defined(RASTERIZER_VEC4_SSE)
+    return { _mm_set_ps(w, z, y, x) };
+#else
+    alignas(16) float p[4] = { x, y, z, w };
+    return Vec4Load(p);
+#endif
+}
+
+/**
+ * @brief Broadcast one float into all four lanes.
+ * @param s The scalar
+ * @return The register { s, s, s, s }
+ */
+inline Vec4 Vec4Splat(float s) {
+#if defined(RASTERIZER_VEC4_SSE)
+    return { _mm_set1_ps(s) };
+#elif defined(RASTERIZER_VEC4_NEON)
+    return { vdupq_n_f32(s) };
+#else
+    return { { s, s, s, s } };
+#endif
+}
+
+/* ---------------------------------
+ ----------- Arithmetic ------------
+ --------------------------------- */
+
+inline Vec4 operator+(Vec4 a, Vec4 b) {
+#if defined(RASTERIZER_VEC4_SSE)
+    return { _mm_add_ps(a.v, b.v) };
+#elif defined(RASTERIZER_VEC4_NEON)
+    return { vaddq_f32(a.v, b.v) };
+#else
+    return { { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] } };
+#endif
+}
+
+inline Vec4 operator-(Vec4 a, Vec4 b) {
+#if defined(RASTERIZER_VEC4_SSE)
+    return { _mm_sub_ps(a.v, b.v) };
+#elif defined(RASTERIZER_VEC4_NEON)
+    return { vsubq_f32(a.v, b.v) };
+#else
+    return { { a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3] } };
+#endif
+}
+
+inline Vec4 operator*(Vec4 a, Vec4 b) {
+#if defined(RASTERIZER_VEC4_SSE)
+    return { _mm_mul_ps(a.v, b.v) };
+#elif defined(RASTERIZER_VEC4_NEON)
+    return { vmulq_f32(a.v, b.v) };
+#else
+    return { { a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3] } };
+#endif
+}
+
+inline Vec4 operator/(Vec4 a, Vec4 b) {
+#if defined(RASTERIZER_VEC4_SSE)
+    return { _mm_div_ps(a.v, b.v) };
+#elif defined(RASTERIZER_VEC4_NEON) && defined(__aarch64__)
+    return { vdivq_f32(a.v, b.v) };
+#else
+    alignas(16) float pa[4], pb[4];
+    Vec4Store(pa, a);
+    Vec4Store(pb, b);
+    return Vec4Set(pa[0] / pb[0], pa[1] / pb[1], pa[2] / pb[2], pa[3] / pb[3]);
+#endif
+}
+
+inline Vec4 operator*(Vec4 a, float s) { return a * Vec4Splat(s); }
+inline Vec4 operator/(Vec4 a, float s) { return a / Vec4Splat(s); }
+
+/* -----------------------------
+ ----------- Utils -------------
+ ----------------------------- */
+
+/**
+ * @brief Read the first lane.
+ * @param a The register
+ * @return Lane x
+ */
+inline float Vec4GetX(Vec4 a) {
+#if defined(RASTERIZER_VEC4_SSE)
+    return _mm_cvtss_f32(a.v);
+#elif defined(RASTERIZER_VEC4_NEON)
+    return vgetq_lane_f32(a.v, 0);
+#else
+    return a.v[0];
+#endif
+}
+
+/**
+ * @brief Dot product of the x y z lanes, w is ignored.
+ * @param a One register
+ * @param b The other register
+ * @return a.x * b.x + a.y * b.y + a.z * b.z
+ */
+inline float Dot3(Vec4 a, Vec4 b) {
+#if defined(RASTERIZER_VEC4_SSE)
+    __m128 m = _mm_mul_ps(a.v, b.v);
+    __m128 y = _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 1, 1, 1));
+    __m128 z = _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 2, 2, 2));
+    return _mm_cvtss_f32(_mm_add_ss(_mm_add_ss(m, y), z));
+#elif defined(RASTERIZER_VEC4_NEON)
+    float32x4_t m = vmulq_f32(a.v, b.v);
+    return vgetq_lane_f32(m, 0) + vgetq_lane_f32(m, 1) + vgetq_lane_f32(m, 2);
+#else
+    return a.v[0] * b.v[0] + a.v[1] * b.v[1] + a.v[2] * b.v[2];
+#endif
+}
+
+/**
+ * @brief Cross product of the x y z lanes, the w lane of the result is 0.
+ * @param a One register
+ * @param b The other register
+ * @return a x b
+ */
+inline Vec4 Cross3(Vec4 a, Vec4 b) {
+#if defined(RASTERIZER_VEC4_SSE)
+    __m128 a_yzx = _mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(3, 0, 2, 1));
+    __m128 b_yzx = _mm_shuffle_ps(b.v, b.v, _MM_SHUFFLE(3, 0, 2, 1));
+    __m128 c = _mm_sub_ps(_mm_mul_ps(a.v, b_yzx), _mm_mul_ps(a_yzx, b.v));
+    return { _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1)) };
+#else
+    alignas(16) float pa[4], pb[4];
+    Vec4Store(pa, a);
+    Vec4Store(pb, b);
+    return Vec4Set(pa[1] * pb[2] - pa[2] * pb[1],
+                   pa[2] * pb[0] - pa[0] * pb[2],
+                   pa[0] * pb[1] - pa[1] * pb[0],
+                   0.0f);
+#endif
+}
+
+/**
+ * @brief Length of the x y z lanes.
+ * @param a The register
+ * @return The length
+ */
+inline float Length3(Vec4 a) {
+    return std::sqrt(Dot3(a, a));
+}
+
+/**
+ * @brief Divide all lanes by the length of x y z. Like the scalar version, a zero vector is not guarded.
+ * @param a The register
+ * @return The normalized register
+ */
+inline Vec4 Normalize3(Vec4 a) {
+    return a / Length3(a);
+}
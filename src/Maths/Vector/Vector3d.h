@@ -1,25 +1,64 @@
 #pragma once
+#include "Vec4.h"
 
 /**
  * @brief A 3D vector in space, x y and z represents coordinate in 3D space.
+ * It is 16-byte aligned so it can be moved in and out of a Vec4 register with a single load/store,
+ * w is only meaningful after a matrix multiplication and is reset to 1 by every vector operation that
+ * returns a new vector. The forms writing to an out parameter (and Normalize in place) only write x, y and z,
+ * the vector written to keeps its w.
  */
-struct Vector3d {
+struct alignas(16) Vector3d {
     float x, y, z, w;
 
     /**
      * @brief Constructor
      */
-    Vector3d();
+    constexpr Vector3d() : x(0.0f), y(0.0f), z(0.0f), w(1.0f) {}
 
     /**
      * @brief Constructor with new x y z
-     * @param new_x 
-     * @param new_y 
-     * @param new_z 
+     * @param new_x
+     * @param new_y
+     * @param new_z
      */
-    Vector3d(float new_x, float new_y, float new_z);
+    constexpr Vector3d(float new_x, float new_y, float new_z) : x(new_x), y(new_y), z(new_z), w(1.0f) {}
 };
 
+/* ---------------------------------
+ ----------- Conversion ------------
+ --------------------------------- */
+
+/**
+ * @brief Load a vector into a register.
+ * @param vec The vector
+ * @return The register { x, y, z, w }
+ */
+inline Vec4 ToVec4(const Vector3d& vec) {
+    return Vec4Load(&vec.x);
+}
+
+/**
+ * @brief Store a register back into a vector, w is set to 1.
+ * @param a The register
+ * @return The vector
+ */
+inline Vector3d ToVector3d(Vec4 a) {
+    Vector3d res;
+    Vec4Store(&res.x, a);
+    res.w = 1.0f;
+    return res;
+}
+
+/* ---------------------------------
+ ------------ Operators ------------
+ --------------------------------- */
+
+inline Vector3d operator+(const Vector3d& a, const Vector3d& b) { return ToVector3d(ToVec4(a) + ToVec4(b)); }
+inline Vector3d operator-(const Vector3d& a, const Vector3d& b) { return ToVector3d(ToVec4(a) - ToVec4(b)); }
+inline Vector3d operator*(const Vector3d& a, float m) { return ToVector3d(ToVec4(a) * m); }
+inline Vector3d operator/(const Vector3d& a, float d) { return ToVector3d(ToVec4(a) / d); }
+
 /* ---------------------------------
  ------------ Addition -------------
  --------------------------------- */
@@ -30,7 +69,11 @@ struct Vector3d {
  * @param input_b The other parameter vector
  * @param out The result vector
  */
-void VectorAdd(Vector3d& input_a, Vector3d& input_b, Vector3d& out);
+inline void VectorAdd(const Vector3d& input_a, const Vector3d& input_b, Vector3d& out) {
+    float w = out.w;
+    out = input_a + input_b;
+    out.w = w;
+}
 
 /**
  * @brief Overloaded version of previous addition.
@@ -38,7 +81,9 @@ void VectorAdd(Vector3d& input_a, Vector3d& input_b, Vector3d& out);
  * @param input_b The other parameter vector
  * @return The result vector
  */
-Vector3d VectorAdd(Vector3d& input_a, Vector3d& input_b);
+inline Vector3d VectorAdd(const Vector3d& input_a, const Vector3d& input_b) {
+    return input_a + input_b;
+}
 
 /* ---------------------------------
  ----------- Subtraction -----------
@@ -50,7 +95,11 @@ Vector3d VectorAdd(Vector3d& input_a, Vector3d& input_b);
  * @param input_b The other parameter vector
  * @param out The result vector
  */
-void VectorSub(Vector3d& input_a, Vector3d& input_b, Vector3d& out);
+inline void VectorSub(const Vector3d& input_a, const Vector3d& input_b, Vector3d& out) {
+    float w = out.w;
+    out = input_a - input_b;
+    out.w = w;
+}
 
 /**
  * @brief This method is an overloaded version of previous subtraction.
@@ -58,7 +107,9 @@ void VectorSub(Vector3d& input_a, Vector3d& input_b, Vector3d& out);
  * @param input_b The other parameter vector
  * @return The result vector
  */
-Vector3d VectorSub(Vector3d& input_a, Vector3d& input_b);
+inline Vector3d VectorSub(const Vector3d& input_a, const Vector3d& input_b) {
+    return input_a - input_b;
+}
 
 /* ---------------------------------
  ----------- Multiplication --------
@@ -70,7 +121,11 @@ Vector3d VectorSub(Vector3d& input_a, Vector3d& input_b);
  * @param m The floating point number
  * @param out A result vector to store the final result
  */
-void VectorMul(Vector3d& input_a, float m, Vector3d& out);
+inline void VectorMul(const Vector3d& input_a, float m, Vector3d& out) {
+    float w = out.w;
+    out = input_a * m;
+    out.w = w;
+}
 
 /**
  * @brief Overloaded version of VectorMul, this one would return a new Vector3d.
@@ -78,7 +133,9 @@ void VectorMul(Vector3d& input_a, float m, Vector3d& out);
  * @param m The floating point number
  * @return A result vector
  */
-Vector3d VectorMul(Vector3d& input_a, float m);
+inline Vector3d VectorMul(const Vector3d& input_a, float m) {
+    return input_a * m;
+}
 
 /* --------------------------------
  ----------- Division -------------
@@ -87,18 +144,27 @@ Vector3d VectorMul(Vector3d& input_a, float m);
 /**
  * @brief Performs Vector division with a float.
  * @param input_a Vector to be divided
- * @param d The float, MAKE SURE this != 0.0f
+ * @param d The float, if this is 0.0f the vector is copied unchanged
  * @param out The result Vector
  */
-void VectorDiv(Vector3d& input_a, float d, Vector3d& out);
+inline void VectorDiv(const Vector3d& input_a, float d, Vector3d& out) {
+    float w = out.w;
+    out = d == 0.0f ? ToVector3d(ToVec4(input_a)) : input_a / d;
+    out.w = w;
+}
 
 /**
  * @brief Performs Vector division with a float, This is overloaded version
  * @param input_a Vector to be divided
- * @param d The float, MAKE SURE this != 0.0f
+ * @param d The float, if this is 0.0f the vector is returned unchanged
  * @return The result Vector
  */
-Vector3d VectorDiv(Vector3d& input_a, float d);
+inline Vector3d VectorDiv(const Vector3d& input_a, float d) {
+    if (d == 0.0f) {
+        return input_a;
+    }
+    return input_a / d;
+}
 
 /* -----------------------------
  ----------- Utils -------------
@@ -110,22 +176,29 @@ Vector3d VectorDiv(Vector3d& input_a, float d);
  * @param input_b The other parameter vector
  * @return the final product of the dot product operation
  */
-float DotProduct(Vector3d input_a, Vector3d input_b);
+inline float DotProduct(const Vector3d& input_a, const Vector3d& input_b) {
+    return Dot3(ToVec4(input_a), ToVec4(input_b));
+}
 
 /**
  * @brief Compute the dot product between two vectors in 3d.
+ * Kept for older call sites, it is the same as DotProduct now that both take references.
  * @param input_a One parameter vector
  * @param input_b The other parameter vector
  * @return the final product of the dot product operation
  */
-float DotProductRef(Vector3d& input_a, Vector3d& input_b);
+inline float DotProductRef(const Vector3d& input_a, const Vector3d& input_b) {
+    return DotProduct(input_a, input_b);
+}
 
 /**
  * @brief Takes in a vector and return its length.
  * @param vec Vector
  * @return The length of vector
  */
-float VectorLength(Vector3d& vec);
+inline float VectorLength(const Vector3d& vec) {
+    return Length3(ToVec4(vec));
+}
 
 /**
  * @brief This method performs a cross product of input_a and input_b in 3d.
@@ -133,7 +206,11 @@ float VectorLength(Vector3d& vec);
  * @param input_b The other parameter vector
  * @param out The result vector
  */
-void CrossProduct(Vector3d& input_a, Vector3d& input_b, Vector3d& out);
+inline void CrossProduct(const Vector3d& input_a, const Vector3d& input_b, Vector3d& out) {
+    float w = out.w;
+    out = ToVector3d(Cross3(ToVec4(input_a), ToVec4(input_b)));
+    out.w = w;
+}
 
 /**
  * @brief Overloaded version of CrossProduct which returns a new Vector.
@@ -141,26 +218,43 @@ void CrossProduct(Vector3d& input_a, Vector3d& input_b, Vector3d& out);
  * @param input_b The other parameter vector
  * @return The result vector
  */
-Vector3d CrossProduct(Vector3d& input_a, Vector3d& input_b);
+inline Vector3d CrossProduct(const Vector3d& input_a, const Vector3d& input_b) {
+    return ToVector3d(Cross3(ToVec4(input_a), ToVec4(input_b)));
+}
 
 /**
  * @brief Normalize the vector.
  * @param vec The Vector3d we need to normalize.
  */
-void Normalize(Vector3d& vec);
+inline void Normalize(Vector3d& vec) {
+    float w = vec.w;
+    vec = ToVector3d(Normalize3(ToVec4(vec)));
+    vec.w = w;
+}
 
 /**
  * @brief Normalize the vector, this function would return a new instance.
  * @param vec The Vector3d we need to normalize.
  */
-Vector3d NormalizeToNew(Vector3d& vec);
+inline Vector3d NormalizeToNew(const Vector3d& vec) {
+    return ToVector3d(Normalize3(ToVec4(vec)));
+}
 
 /**
  * @brief Performs a intersection test with line/vector and return the intersection points in Vector 3d
  * @param plane_p The input plane points
- * @param plane_n The normal of input plane
+ * @param plane_n The normal of input plane, it does not need to be normalized
  * @param line_start The line starting position
  * @param line_end The line ending position
  * @return The intersection point
  */
-Vector3d IntersectPlane(Vector3d& plane_p, Vector3d& plane_n, Vector3d& line_start, Vector3d& line_end);
+inline Vector3d IntersectPlane(const Vector3d& plane_p, const Vector3d& plane_n, const Vector3d& line_start, const Vector3d& line_end) {
+    Vec4 n = Normalize3(ToVec4(plane_n));
+    Vec4 a = ToVec4(line_start);
+    Vec4 b = ToVec4(line_end);
+    float plane_d = -Dot3(n, ToVec4(plane_p));
+    float ad = Dot3(a, n);
+    float bd = Dot3(b, n);
+    float t = (-plane_d - ad) / (bd - ad);
+    return ToVector3d(a + (b - a) * t);
+}
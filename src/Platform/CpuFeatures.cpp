@@ -0,0 +1,138 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include "CpuFeatures.h"
+
+#if defined(RASTERIZER_X86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace {
+
+#if defined(RASTERIZER_X86)
+
+/**
+ * @brief cpuid with a sub-leaf, regs receives eax ebx ecx edx.
+ */
+void CpuId(unsigned leaf, unsigned sub_leaf, unsigned regs[4]) {
+#if defined(_MSC_VER)
+    int r[4];
+    __cpuidex(r, (int)leaf, (int)sub_leaf);
+    for (int i = 0; i < 4; ++i) regs[i] = (unsigned)r[i];
+#else
+    __cpuid_count(leaf, sub_leaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+/**
+ * @brief Which register states the OS saves on a context switch (XCR0).
+ */
+unsigned long long ReadXcr0() {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((unsigned long long)edx << 32) | eax;
+#endif
+}
+
+#endif
+
+/**
+ * @brief Parse RASTERIZER_CPU.
+ * @param value The variable, may be null
+ * @param level Receives the requested tier
+ * @return true if the variable held a known tier
+ */
+bool ParseCpuLevel(const char* value, CpuLevel& level) {
+    if (value == nullptr) {
+        return false;
+    }
+    if (std::strcmp(value, "scalar") == 0) { level = CpuLevel::Scalar; return true; }
+    if (std::strcmp(value, "simd128") == 0 || std::strcmp(value, "sse2") == 0 || std::strcmp(value, "neon") == 0) {
+        level = CpuLevel::Simd128;
+        return true;
+    }
+    if (std::strcmp(value, "avx2") == 0) { level = CpuLevel::Avx2; return true; }
+    if (std::strcmp(value, "avx512") == 0) { level = CpuLevel::Avx512; return true; }
+    return false;
+}
+
+CpuLevel SelectCpuLevel() {
+    CpuLevel detected = DetectCpuLevel();
+    const char* env = std::getenv("RASTERIZER_CPU");
+    CpuLevel requested;
+    if (env == nullptr) {
+        return detected;
+    }
+    if (!ParseCpuLevel(env, requested)) {
+        std::cerr << "RASTERIZER_CPU=" << env << " is not a known tier, using " << CpuLevelName(detected) << ".\n";
+        return detected;
+    }
+    if (requested > detected) {
+        std::cerr << "RASTERIZER_CPU=" << env << " is not supported by this CPU, using " << CpuLevelName(detected) << ".\n";
+        return detected;
+    }
+    return requested;
+}
+
+}
+
+CpuLevel DetectCpuLevel() {
+#if defined(RASTERIZER_X86)
+    unsigned regs[4];
+    CpuId(0, 0, regs);
+    unsigned max_leaf = regs[0];
+
+    CpuId(1, 0, regs);
+    bool sse2 = (regs[3] & (1u << 26)) != 0;
+    bool fma = (regs[2] & (1u << 12)) != 0;
+    bool osxsave = (regs[2] & (1u << 27)) != 0;
+    bool avx = (regs[2] & (1u << 28)) != 0;
+    if (!sse2) {
+        return CpuLevel::Scalar;
+    }
+
+    // AVX needs the OS to save the YMM state (XCR0 bits 1 and 2), AVX-512 also the opmask and ZMM state (bits 5 to 7)
+    unsigned long long xcr0 = osxsave ? ReadXcr0() : 0;
+    bool os_avx = (xcr0 & 0x6) == 0x6;
+    bool os_avx512 = (xcr0 & 0xe6) == 0xe6;
+
+    bool avx2 = false, avx512f = false;
+    if (max_leaf >= 7) {
+        CpuId(7, 0, regs);
+        avx2 = (regs[1] & (1u << 5)) != 0;
+        avx512f = (regs[1] & (1u << 16)) != 0;
+    }
+
+    if (avx && avx2 && fma && os_avx) {
+        return avx512f && os_avx512 ? CpuLevel::Avx512 : CpuLevel::Avx2;
+    }
+    return CpuLevel::Simd128;
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+    return CpuLevel::Simd128;
+#else
+    return CpuLevel::Scalar;
+#endif
+}
+
+CpuLevel ActiveCpuLevel() {
+    static const CpuLevel level = SelectCpuLevel();
+    return level;
+}
+
+const char* CpuLevelName(CpuLevel level) {
+    switch (level) {
+        case CpuLevel::Scalar: return "scalar";
+        case CpuLevel::Simd128: return "simd128";
+        case CpuLevel::Avx2: return "avx2";
+        case CpuLevel::Avx512: return "avx512";
+    }
+    return "unknown";
+}
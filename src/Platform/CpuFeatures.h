@@ -0,0 +1,46 @@
+#pragma once
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define RASTERIZER_X86 1
+#endif
+
+// Kernels for instruction sets above the build baseline are compiled per function. MSVC accepts any
+// intrinsic without flags, GCC and Clang need the target attribute on the function that uses them.
+#if defined(_MSC_VER) && !defined(__clang__)
+#define RASTERIZER_TARGET_AVX2
+#define RASTERIZER_TARGET_AVX512
+#else
+#define RASTERIZER_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define RASTERIZER_TARGET_AVX512 __attribute__((target("avx512f,avx2,fma")))
+#endif
+
+/**
+ * @brief The instruction set tiers the hot kernels are built for, ordered from oldest to newest.
+ */
+enum class CpuLevel {
+    Scalar,     // No SIMD at all, the reference implementation
+    Simd128,    // SSE2 on x86, NEON on ARM (whatever Vec4 is built on)
+    Avx2,       // AVX2 + FMA, 8 floats per instruction
+    Avx512,     // AVX-512F, 16 floats per instruction
+};
+
+/**
+ * @brief Ask the CPU (cpuid, and xgetbv for the OS side of AVX) which tier it supports.
+ * @return The best supported tier
+ */
+CpuLevel DetectCpuLevel();
+
+/**
+ * @brief The tier the kernels dispatch on. Detected once on first use, it can be lowered for testing
+ * with the RASTERIZER_CPU environment variable (scalar, simd128/sse2/neon, avx2, avx512).
+ * Asking for a tier the CPU does not support falls back to the detected one.
+ * @return The active tier
+ */
+CpuLevel ActiveCpuLevel();
+
+/**
+ * @brief Human readable name of a tier, the same spelling RASTERIZER_CPU accepts.
+ * @param level The tier
+ * @return The name
+ */
+const char* CpuLevelName(CpuLevel level);
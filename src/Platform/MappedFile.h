@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief A whole file mapped read-only into memory, unmapped when the object goes away.
+ * The bytes are used in place, nothing is copied, and the OS pages them in on first touch.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    /**
+     * @brief Map a file, any previous mapping is released first.
+     * @param path Path of the file
+     * @return true if the file is mapped (an empty file maps to Data() == nullptr, Size() == 0)
+     */
+    bool Open(const std::string& path);
+
+    /**
+     * @brief Release the mapping.
+     */
+    void Close();
+
+    const char* Data() const { return data_; }
+    size_t Size() const { return size_; }
+    bool IsOpen() const { return open_; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool open_ = false;
+#if defined(_WIN32)
+    void* file_ = nullptr;      // HANDLE of the file
+    void* mapping_ = nullptr;   // HANDLE of the file mapping
+#endif
+};
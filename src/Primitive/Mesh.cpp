@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include "Mesh.h"
+#include "../Loader/MeshCache.h"
+#include "../Platform/MappedFile.h"
+#include "../Maths/Vector/NormalizeBatch.h"
+
+namespace {
+
+/**
+ * @brief Merges vertices with bit-identical positions while a mesh is being built.
+ */
+class VertexWelder {
+public:
+    explicit VertexWelder(VertexStreamSoA& positions) : positions_(positions) {}
+
+    /**
+     * @brief Index of the vertex at this position, appended if it is new.
+     * @param vec The position
+     * @return Index into positions
+     */
+    uint32_t Add(const Vector3d& vec) {
+        Key key;
+        std::memcpy(&key.x, &vec.x, sizeof(float));
+        std::memcpy(&key.y, &vec.y, sizeof(float));
+        std::memcpy(&key.z, &vec.z, sizeof(float));
+        auto found = lookup_.emplace(key, (uint32_t)positions_.Size());
+        if (found.second) {
+            positions_.PushBack(vec);
+        }
+        return found.first->second;
+    }
+
+private:
+    struct Key {
+        uint32_t x, y, z;
+        bool operator==(const Key& o) const { return x == o.x && y == o.y && z == o.z; }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& k) const {
+            uint64_t h = k.x * 0x9E3779B97F4A7C15ull;
+            h ^= (h >> 29) + k.y * 0xBF58476D1CE4E5B9ull;
+            h ^= (h >> 31) + k.z * 0x94D049BB133111EBull;
+            return (size_t)(h ^ (h >> 32));
+        }
+    };
+
+    VertexStreamSoA& positions_;
+    std::unordered_map<Key, uint32_t, KeyHash> lookup_;
+};
+
+}
+
+std::string ObjectFilePath(const std::string& filename) {
+    return "Objects/" + filename;
+}
+
+bool Mesh::LoadFromObjFile(const std::string& filename, ObjLoadStats* stats) {
+    return LoadObjCached(ObjectFilePath(filename), *this, stats);
+}
+
+void Mesh::FromTriangles(const std::vector<Triangle>& tris) {
+    VertexStreamSoA new_positions;
+    std::vector<uint32_t> new_indices;
+    new_indices.reserve(tris.size() * 3);
+
+    VertexWelder welder(new_positions);
+    for (const Triangle& tri : tris) {
+        for (int i = 0; i < 3; ++i) {
+            new_indices.push_back(welder.Add(tri.pts[i]));
+        }
+    }
+
+    SetGeometry(std::move(new_positions), std::move(new_indices));
+}
+
+void Mesh::SetGeometry(VertexStreamSoA&& new_positions, std::vector<uint32_t>&& new_indices) {
+    mapping_.reset();
+    position_data_ = std::move(new_positions);
+    index_data_ = std::move(new_indices);
+    meshlet_data_.clear();
+    bvh_data_.clear();
+    positions = position_data_;
+    indices = index_data_;
+    meshlets = {};
+    meshlet_bvh = {};
+    ComputeNormals();
+    ComputeBounds();
+}
+
+void Mesh::SetMeshlets(std::vector<Meshlet>&& new_meshlets, std::vector<BvhNode>&& new_bvh) {
+    meshlet_data_ = std::move(new_meshlets);
+    bvh_data_ = std::move(new_bvh);
+    meshlets = meshlet_data_;
+    meshlet_bvh = bvh_data_;
+}
+
+void Mesh::SetMapped(std::shared_ptr<const MappedFile> file, VertexStreamView new_positions, Span<const uint32_t> new_indices,
+                     VertexStreamView new_normals, Span<const Meshlet> new_meshlets, Span<const BvhNode> new_meshlet_bvh,
+                     const Vector3d& new_bounds_min, const Vector3d& new_bounds_max) {
+    // Point at the new arrays before the old storage goes, so the views never dangle
+    positions = new_positions;
+    indices = new_indices;
+    normals = new_normals;
+    meshlets = new_meshlets;
+    meshlet_bvh = new_meshlet_bvh;
+    bounds_min = new_bounds_min;
+    bounds_max = new_bounds_max;
+    mapping_ = std::move(file);
+    position_data_ = {};
+    index_data_ = {};
+    normal_data_ = {};
+    meshlet_data_ = {};
+    bvh_data_ = {};
+}
+
+void Mesh::ComputeNormals() {
+    // Unnormalized cross products first, then normalize all of them in one batch
+    size_t tri_count = TriangleCount();
+    VertexStreamSoA new_normals;
+    new_normals.Resize(tri_count);
+    for (size_t t = 0; t < tri_count; ++t) {
+        Vector3d p0 = Corner(t, 0);
+        Vector3d n = CrossProduct(Corner(t, 1) - p0, Corner(t, 2) - p0);
+        new_normals.x[t] = n.x;
+        new_normals.y[t] = n.y;
+        new_normals.z[t] = n.z;
+    }
+    NormalizeSoA(new_normals.x.data(), new_normals.y.data(), new_normals.z.data(), new_normals.Size());
+    normal_data_ = std::move(new_normals);
+    normals = normal_data_;
+}
+
+void Mesh::ComputeBounds() {
+    if (positions.Size() == 0) {
+        bounds_min = bounds_max = Vector3d();
+        return;
+    }
+    bounds_min = bounds_max = positions.Get(0);
+    for (size_t i = 1; i < positions.Size(); ++i) {
+        bounds_min.x = std::min(bounds_min.x, positions.x[i]);
+        bounds_min.y = std::min(bounds_min.y, positions.y[i]);
+        bounds_min.z = std::min(bounds_min.z, positions.z[i]);
+        bounds_max.x = std::max(bounds_max.x, positions.x[i]);
+        bounds_max.y = std::max(bounds_max.y, positions.y[i]);
+        bounds_max.z = std::max(bounds_max.z, positions.z[i]);
+    }
+}
@@ -1,66 +1,128 @@
 #pragma once
+#include <cstdint>
+#include <memory>
 #include <vector>
-#include <fstream>
-#include <strstream>
-#include <iostream>
+#include <string>
+#include "Meshlet.h"
+#include "../Maths/Geometry/Bvh.h"
 #include "Triangle.h"
+#include "../Maths/Matrix/TransformBatch.h"
+#include "../Utils/Span.h"
+
+struct ObjLoadStats;
+class MappedFile;
 
 /**
  * @brief A Mesh of multiple Triangles, use this to represent arbitrary type of objects.
+ * It is indexed: every distinct corner is stored once in positions, and triangles refer to their corners
+ * through indices, so a vertex shared by six triangles is also loaded and transformed once.
+ * Vertices keep the order of the file they come from.
+ *
+ * The renderer only reads the views. They point either into arrays the mesh owns, or straight into a
+ * memory mapped mesh cache (see MeshCache.h), in which case the mesh keeps the mapping alive and nothing
+ * was copied. A mesh can be moved but not copied, the views would still point at the original.
  */
 struct Mesh {
-    std::vector<Triangle> tris;
+    VertexStreamView positions;     // Unique vertices in object space
+    Span<const uint32_t> indices;   // Three indices into positions per triangle
+    VertexStreamView normals;       // Unit face normals in object space, one per triangle
+    Vector3d bounds_min;            // Object space bounding box of positions
+    Vector3d bounds_max;
+    Span<const Meshlet> meshlets;   // Clusters covering all triangles in order, empty if not built (see BuildMeshlets)
+    Span<const BvhNode> meshlet_bvh;    // Hierarchy over the meshlets, its leaf order is the meshlet order
+
+    Mesh() = default;
+    Mesh(Mesh&&) = default;
+    Mesh& operator=(Mesh&&) = default;
+    Mesh(const Mesh&) = delete;
+    Mesh& operator=(const Mesh&) = delete;
 
-    // We are only having one function here so I put implementation here in the header
+    /**
+     * @brief Number of triangles.
+     * @return The triangle count
+     */
+    size_t TriangleCount() const { return indices.Size() / 3; }
 
     /**
-     * @brief Load obj file using the string "filename".
+     * @brief Corner of a triangle.
+     * @param t Index of the triangle
+     * @param i Which corner, 0 to 2
+     * @return The corner in object space
+     */
+    Vector3d Corner(size_t t, int i) const { return positions.Get(indices[t * 3 + i]); }
+
+    /**
+     * @brief Load obj file using the string "filename", the file is looked up in Objects/.
+     * A binary cache is kept next to it and used instead of the text while the OBJ is unchanged.
      * @param filename The string representing the obj file
+     * @param stats Receives size, counts and parse time of the file, may be nullptr
      * @return true if successfully loaded, otherwise false
     */
-    bool LoadFromObjFile(std::string filename) {
-        std::string path = "Objects/" + filename;
-        std::ifstream f(path);
+    bool LoadFromObjFile(const std::string& filename, ObjLoadStats* stats = nullptr);
 
-        // If the file cannot be opened
-        if (!f.is_open()) {
-            std::cerr << "The file cannot be opened.\n";
-            return false;
-        }
+    /**
+     * @brief Build the mesh from a triangle soup, corners with identical positions are merged.
+     * @param tris The triangles
+     */
+    void FromTriangles(const std::vector<Triangle>& tris);
 
-        // A cache for vertices
-        std::vector<Vector3d> vertices;
-        while (!f.eof()) {
+    /**
+     * @brief Take over vertex and index arrays, normals and bounds are computed from them, meshlets are dropped.
+     * @param new_positions The vertices
+     * @param new_indices Three indices into new_positions per triangle
+     */
+    void SetGeometry(VertexStreamSoA&& new_positions, std::vector<uint32_t>&& new_indices);
 
-            // String buffer
-            char line[128];
+    /**
+     * @brief Point the mesh at arrays that live in a mapped file, nothing is copied.
+     * @param file The mapping, kept alive as long as the mesh uses it
+     * @param new_positions The vertices, inside the mapping
+     * @param new_indices The indices, inside the mapping
+     * @param new_normals The face normals, inside the mapping
+     * @param new_meshlets The meshlets, inside the mapping
+     * @param new_meshlet_bvh The hierarchy over the meshlets, inside the mapping
+     * @param new_bounds_min Lower corner of the bounding box
+     * @param new_bounds_max Upper corner of the bounding box
+     */
+    void SetMapped(std::shared_ptr<const MappedFile> file, VertexStreamView new_positions, Span<const uint32_t> new_indices,
+                   VertexStreamView new_normals, Span<const Meshlet> new_meshlets, Span<const BvhNode> new_meshlet_bvh,
+                   const Vector3d& new_bounds_min, const Vector3d& new_bounds_max);
 
-            // Read the line
-            f.getline(line, 128);
+    /**
+     * @brief Take over the meshlets, they must cover the triangles of the mesh in order.
+     * @param new_meshlets The meshlets
+     * @param new_bvh Hierarchy over the meshlets whose item ranges index the meshlets directly
+     */
+    void SetMeshlets(std::vector<Meshlet>&& new_meshlets, std::vector<BvhNode>&& new_bvh);
 
-            // String stream buffer
-            std::strstream s;
+    /**
+     * @brief Recompute the face normals from the triangle corners.
+     * The mesh is static, so this runs once at load instead of once per triangle per frame.
+     */
+    void ComputeNormals();
 
-            // Input the line
-            s << line;
+    /**
+     * @brief Recompute the bounding box from the positions.
+     */
+    void ComputeBounds();
 
-            // Junk, as we don't need the first character to be stored
-            char junk;
+    /**
+     * @return true if the arrays live in a mapped file rather than in the mesh
+     */
+    bool IsMapped() const { return mapping_ != nullptr; }
 
-            // If currently the line represent a vertex
-            if (line[0] == 'v') {
-                Vector3d vec{};
-                s >> junk >> vec.x >> vec.y >> vec.z;
-                vertices.push_back(vec);
-            }
-            // If currently the line represent a triangle
-            if (line[0] == 'f') {
-                int f[3]{};
-                s >> junk >> f[0] >> f[1] >> f[2];
-                tris.push_back({ vertices[f[0] - 1], vertices[f[1] - 1], vertices[f[2] - 1] });
-            }
-        }
+private:
+    VertexStreamSoA position_data_;         // Owned arrays, unused while the mesh is mapped
+    std::vector<uint32_t> index_data_;
+    VertexStreamSoA normal_data_;
+    std::vector<Meshlet> meshlet_data_;
+    std::vector<BvhNode> bvh_data_;
+    std::shared_ptr<const MappedFile> mapping_;
+};
 
-        return true;
-    }
-};
\ No newline at end of file
+/**
+ * @brief Where LoadFromObjFile looks for a file.
+ * @param filename Name of the obj file
+ * @return The path, relative to the working directory
+ */
+std::string ObjectFilePath(const std::string& filename);
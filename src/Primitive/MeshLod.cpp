@@ -0,0 +1,388 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <queue>
+#include "MeshLod.h"
+#include "MeshOptimizer.h"
+
+namespace {
+
+constexpr uint32_t NO_VERTEX = 0xFFFFFFFFu;
+
+/**
+ * @brief Symmetric 4x4 matrix of a sum of planes, v^T Q v is the sum of squared distances of v to them.
+ */
+struct Quadric {
+    double aa = 0, ab = 0, ac = 0, ad = 0, bb = 0, bc = 0, bd = 0, cc = 0, cd = 0, dd = 0;
+    double weight = 0;  // Sum of the plane weights, Evaluate / weight is a mean squared distance
+
+    /**
+     * @brief Add the plane ax + by + cz + d = 0, (a, b, c) must be unit length.
+     */
+    void AddPlane(double a, double b, double c, double d, double w) {
+        aa += w * a * a; ab += w * a * b; ac += w * a * c; ad += w * a * d;
+        bb += w * b * b; bc += w * b * c; bd += w * b * d;
+        cc += w * c * c; cd += w * c * d;
+        dd += w * d * d;
+        weight += w;
+    }
+
+    Quadric& operator+=(const Quadric& o) {
+        aa += o.aa; ab += o.ab; ac += o.ac; ad += o.ad; bb += o.bb;
+        bc += o.bc; bd += o.bd; cc += o.cc; cd += o.cd; dd += o.dd;
+        weight += o.weight;
+        return *this;
+    }
+
+    double Evaluate(double x, double y, double z) const {
+        return aa * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x
+             + bb * y * y + 2 * bc * y * z + 2 * bd * y
+             + cc * z * z + 2 * cd * z
+             + dd;
+    }
+
+    /**
+     * @brief The point where the error is smallest.
+     * @return false if the planes do not pin down a single point
+     */
+    bool Minimum(double& x, double& y, double& z) const {
+        double det = aa * (bb * cc - bc * bc) - ab * (ab * cc - bc * ac) + ac * (ab * bc - bb * ac);
+        double scale = aa * aa + bb * bb + cc * cc;
+        if (std::fabs(det) <= 1e-9 * scale * std::sqrt(scale)) {
+            return false;
+        }
+        double inv = 1.0 / det;
+        x = -inv * (ad * (bb * cc - bc * bc) - ab * (bd * cc - bc * cd) + ac * (bd * bc - bb * cd));
+        y = -inv * (aa * (bd * cc - cd * bc) - ad * (ab * cc - bc * ac) + ac * (ab * cd - bd * ac));
+        z = -inv * (aa * (bb * cd - bc * bd) - ab * (ab * cd - bd * ac) + ad * (ab * bc - bb * ac));
+        return true;
+    }
+};
+
+struct Collapse {
+    double cost;                    // Squared error summed over all planes, the queue order
+    double error;                   // Root mean squared distance to the planes
+    uint32_t keep, drop;            // drop is merged into keep
+    uint32_t keep_stamp, drop_stamp;// Versions of both vertices when this was computed
+    float x, y, z;                  // Where keep goes
+
+    bool operator>(const Collapse& o) const { return cost > o.cost; }
+};
+
+/**
+ * @brief The state of one simplification run.
+ */
+class Simplifier {
+public:
+    explicit Simplifier(const Mesh& mesh) {
+        const size_t vertex_count = mesh.positions.Size();
+        const size_t tri_count = mesh.TriangleCount();
+        pos_.resize(vertex_count);
+        for (size_t v = 0; v < vertex_count; ++v) {
+            pos_[v] = { (double)mesh.positions.x[v], (double)mesh.positions.y[v], (double)mesh.positions.z[v] };
+        }
+        tris_.assign(mesh.indices.begin(), mesh.indices.end());
+        tri_alive_.assign(tri_count, 1);
+        live_tris_ = tri_count;
+        quadrics_.resize(vertex_count);
+        stamp_.assign(vertex_count, 0);
+        vertex_alive_.assign(vertex_count, 1);
+        vertex_tris_.resize(vertex_count);
+
+        for (size_t t = 0; t < tri_count; ++t) {
+            double n[3], d;
+            if (!Plane(t, n, d)) {
+                continue;
+            }
+            for (int c = 0; c < 3; ++c) {
+                quadrics_[tris_[t * 3 + c]].AddPlane(n[0], n[1], n[2], d, 1.0);
+            }
+        }
+        for (size_t t = 0; t < tri_count; ++t) {
+            for (int c = 0; c < 3; ++c) {
+                vertex_tris_[tris_[t * 3 + c]].push_back((uint32_t)t);
+            }
+        }
+
+        // Edges as (low, high) keys, one that only one triangle uses is on the boundary
+        std::vector<uint64_t> edges;
+        edges.reserve(tri_count * 3);
+        for (size_t t = 0; t < tri_count; ++t) {
+            for (int c = 0; c < 3; ++c) {
+                edges.push_back(EdgeKey(tris_[t * 3 + c], tris_[t * 3 + (c + 1) % 3]));
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+        boundary_.assign(vertex_count, 0);
+        for (size_t i = 0; i < edges.size(); ++i) {
+            bool shared = (i > 0 && edges[i - 1] == edges[i]) || (i + 1 < edges.size() && edges[i + 1] == edges[i]);
+            if (!shared) {
+                boundary_[(uint32_t)(edges[i] >> 32)] = 1;
+                boundary_[(uint32_t)edges[i]] = 1;
+            }
+        }
+
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+        for (uint64_t key : edges) {
+            Push((uint32_t)(key >> 32), (uint32_t)key);
+        }
+    }
+
+    size_t LiveTriangles() const { return live_tris_; }
+    double MaxError() const { return max_error_; }
+
+    /**
+     * @brief Collapse edges until at most target triangles are left or nothing can be collapsed.
+     */
+    void Run(size_t target) {
+        while (live_tris_ > target && !heap_.empty()) {
+            Collapse c = heap_.top();
+            heap_.pop();
+            if (!vertex_alive_[c.keep] || !vertex_alive_[c.drop] ||
+                stamp_[c.keep] != c.keep_stamp || stamp_[c.drop] != c.drop_stamp) {
+                continue;
+            }
+            if (Flips(c.keep, c.drop, c.x, c.y, c.z) || Flips(c.drop, c.keep, c.x, c.y, c.z)) {
+                continue;
+            }
+            Apply(c);
+        }
+    }
+
+    /**
+     * @brief The current surface as a mesh of its own, vertices renumbered and optimized.
+     */
+    Mesh Snapshot() const {
+        std::vector<uint32_t> remap(pos_.size(), NO_VERTEX);
+        VertexStreamSoA positions;
+        std::vector<uint32_t> indices;
+        indices.reserve(live_tris_ * 3);
+        for (size_t t = 0; t < tri_alive_.size(); ++t) {
+            if (!tri_alive_[t]) {
+                continue;
+            }
+            for (int c = 0; c < 3; ++c) {
+                uint32_t v = tris_[t * 3 + c];
+                if (remap[v] == NO_VERTEX) {
+                    remap[v] = (uint32_t)positions.Size();
+                    positions.PushBack({ (float)pos_[v].x, (float)pos_[v].y, (float)pos_[v].z });
+                }
+                indices.push_back(remap[v]);
+            }
+        }
+        Mesh mesh;
+        mesh.SetGeometry(std::move(positions), std::move(indices));
+        OptimizeMesh(mesh);
+        BuildMeshlets(mesh);
+        return mesh;
+    }
+
+private:
+    struct Point { double x, y, z; };
+
+    std::vector<Point> pos_;
+    std::vector<uint32_t> tris_;
+    std::vector<char> tri_alive_;
+    std::vector<Quadric> quadrics_;
+    std::vector<uint32_t> stamp_;
+    std::vector<char> vertex_alive_;
+    std::vector<char> boundary_;            // On an edge of only one triangle, never moved or removed
+    std::vector<std::vector<uint32_t>> vertex_tris_;
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> heap_;
+    size_t live_tris_ = 0;
+    double max_error_ = 0.0;
+
+    static uint64_t EdgeKey(uint32_t a, uint32_t b) {
+        return a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+    }
+
+    static void Cross(const Point& u, const Point& v, double n[3]) {
+        n[0] = u.y * v.z - u.z * v.y;
+        n[1] = u.z * v.x - u.x * v.z;
+        n[2] = u.x * v.y - u.y * v.x;
+    }
+
+    static Point Sub(const Point& a, const Point& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+
+    /**
+     * @brief Unit normal and offset of a triangle, false if it has no area.
+     */
+    bool Plane(size_t t, double n[3], double& d) const {
+        const Point& p0 = pos_[tris_[t * 3]];
+        Cross(Sub(pos_[tris_[t * 3 + 1]], p0), Sub(pos_[tris_[t * 3 + 2]], p0), n);
+        double len = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (len <= 0.0) {
+            return false;
+        }
+        n[0] /= len; n[1] /= len; n[2] /= len;
+        d = -(n[0] * p0.x + n[1] * p0.y + n[2] * p0.z);
+        return true;
+    }
+
+    /**
+     * @brief Queue the collapse of edge (a, b) at its best position.
+     */
+    void Push(uint32_t a, uint32_t b) {
+        // Boundary vertices stay where they are, so meshes cut from a larger one still meet their neighbours.
+        // An edge between two of them is never collapsed, one with a single one collapses onto it
+        if (boundary_[a] && boundary_[b]) {
+            return;
+        }
+        if (boundary_[b]) {
+            std::swap(a, b);
+        }
+        Quadric q = quadrics_[a];
+        q += quadrics_[b];
+
+        // The optimal point if there is one, otherwise the best of the two ends and the middle
+        Point candidates[4] = { pos_[a], pos_[b],
+                                { (pos_[a].x + pos_[b].x) * 0.5, (pos_[a].y + pos_[b].y) * 0.5, (pos_[a].z + pos_[b].z) * 0.5 } };
+        int candidate_count = boundary_[a] ? 1 : 3;
+        if (!boundary_[a] && q.Minimum(candidates[3].x, candidates[3].y, candidates[3].z)) {
+            // Nearly flat neighbourhoods give a badly conditioned minimum far off the edge, keep it close
+            Point edge = Sub(pos_[b], pos_[a]);
+            Point off = Sub(candidates[3], candidates[2]);
+            double edge_len2 = edge.x * edge.x + edge.y * edge.y + edge.z * edge.z;
+            if (off.x * off.x + off.y * off.y + off.z * off.z <= edge_len2) {
+                candidates[0] = candidates[3];
+                candidate_count = 1;
+            }
+        }
+        Point best = candidates[0];
+        double best_cost = q.Evaluate(best.x, best.y, best.z);
+        for (int i = 1; i < candidate_count; ++i) {
+            double cost = q.Evaluate(candidates[i].x, candidates[i].y, candidates[i].z);
+            if (cost < best_cost) {
+                best_cost = cost;
+                best = candidates[i];
+            }
+        }
+
+        best_cost = std::max(0.0, best_cost);
+        double error = q.weight > 0.0 ? std::sqrt(best_cost / q.weight) : 0.0;
+        heap_.push({ best_cost, error, a, b, stamp_[a], stamp_[b], (float)best.x, (float)best.y, (float)best.z });
+    }
+
+    /**
+     * @brief Would moving v to (x, y, z) turn one of its triangles (except those shared with other) over?
+     */
+    bool Flips(uint32_t v, uint32_t other, float x, float y, float z) const {
+        Point target = { x, y, z };
+        for (uint32_t t : vertex_tris_[v]) {
+            if (!tri_alive_[t]) {
+                continue;
+            }
+            const uint32_t* tri = &tris_[t * 3];
+            if (tri[0] == other || tri[1] == other || tri[2] == other) {
+                continue;
+            }
+            Point p[3], q[3];
+            for (int c = 0; c < 3; ++c) {
+                p[c] = pos_[tri[c]];
+                q[c] = tri[c] == v ? target : p[c];
+            }
+            double before[3], after[3];
+            Cross(Sub(p[1], p[0]), Sub(p[2], p[0]), before);
+            Cross(Sub(q[1], q[0]), Sub(q[2], q[0]), after);
+            double dot = before[0] * after[0] + before[1] * after[1] + before[2] * after[2];
+            double len_after = after[0] * after[0] + after[1] * after[1] + after[2] * after[2];
+            if (dot <= 0.0 || len_after <= 0.0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void Apply(const Collapse& c) {
+        pos_[c.keep] = { c.x, c.y, c.z };
+        quadrics_[c.keep] += quadrics_[c.drop];
+        vertex_alive_[c.drop] = 0;
+        ++stamp_[c.keep];
+        max_error_ = std::max(max_error_, c.error);
+
+        // Triangles on the collapsed edge disappear, the others of drop move over to keep
+        std::vector<uint32_t>& keep_tris = vertex_tris_[c.keep];
+        for (uint32_t t : vertex_tris_[c.drop]) {
+            if (!tri_alive_[t]) {
+                continue;
+            }
+            uint32_t* tri = &tris_[t * 3];
+            if (tri[0] == c.keep || tri[1] == c.keep || tri[2] == c.keep) {
+                tri_alive_[t] = 0;
+                --live_tris_;
+                continue;
+            }
+            for (int k = 0; k < 3; ++k) {
+                if (tri[k] == c.drop) {
+                    tri[k] = c.keep;
+                }
+            }
+            keep_tris.push_back(t);
+        }
+        vertex_tris_[c.drop].clear();
+        vertex_tris_[c.drop].shrink_to_fit();
+        keep_tris.erase(std::remove_if(keep_tris.begin(), keep_tris.end(), [&](uint32_t t) { return !tri_alive_[t]; }),
+                        keep_tris.end());
+
+        // Every edge around keep changed cost
+        std::vector<uint32_t> neighbours;
+        for (uint32_t t : keep_tris) {
+            for (int k = 0; k < 3; ++k) {
+                uint32_t n = tris_[t * 3 + k];
+                if (n != c.keep) {
+                    neighbours.push_back(n);
+                }
+            }
+        }
+        std::sort(neighbours.begin(), neighbours.end());
+        neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+        for (uint32_t n : neighbours) {
+            Push(c.keep, n);
+        }
+    }
+};
+
+}
+
+void SimplifyMesh(const Mesh& mesh, const std::vector<size_t>& targets, std::vector<Mesh>& out, std::vector<float>& errors) {
+    Simplifier simplifier(mesh);
+    for (size_t target : targets) {
+        simplifier.Run(target);
+        out.push_back(simplifier.Snapshot());
+
+        // The largest collapse so far, as a distance from the planes of the original triangles
+        errors.push_back((float)simplifier.MaxError());
+    }
+}
+
+void BuildMeshLod(Mesh&& mesh, int max_levels, float ratio, size_t min_triangles, MeshLod& lod) {
+    lod.levels.clear();
+    lod.errors.clear();
+
+    std::vector<size_t> targets;
+    size_t count = mesh.TriangleCount();
+    for (int level = 1; level < max_levels; ++level) {
+        count = (size_t)(count * ratio);
+        if (count < min_triangles) {
+            break;
+        }
+        targets.push_back(count);
+    }
+
+    std::vector<Mesh> simplified;
+    std::vector<float> errors;
+    if (!targets.empty()) {
+        SimplifyMesh(mesh, targets, simplified, errors);
+    }
+
+    lod.levels.push_back(std::move(mesh));
+    lod.errors.push_back(0.0f);
+    for (size_t i = 0; i < simplified.size(); ++i) {
+        // A level that could not get smaller than the one before it is no use
+        if (simplified[i].TriangleCount() >= lod.levels.back().TriangleCount()) {
+            break;
+        }
+        lod.levels.push_back(std::move(simplified[i]));
+        lod.errors.push_back(errors[i]);
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "Mesh.h"
+
+/*
+ * Levels of detail of one mesh, generated at load with quadric error metric simplification
+ * (Garland and Heckbert, 1997): edges are collapsed cheapest first, where the cost of moving a vertex is the
+ * sum of squared distances to the planes of the triangles it started on. Each level remembers how far
+ * (in object space units) its surface may be from the original, so the renderer can project that error
+ * to pixels and pick the coarsest level that still looks the same.
+ */
+
+/**
+ * @brief A mesh and its simplified versions, finest first.
+ */
+struct MeshLod {
+    std::vector<Mesh> levels;   // levels[0] is the full mesh, every next one has about ratio times the triangles
+    std::vector<float> errors;  // Object space error of every level, errors[0] is 0
+
+    /**
+     * @return Number of levels
+     */
+    size_t LevelCount() const { return levels.size(); }
+};
+
+/**
+ * @brief Simplify a mesh down to a number of triangles, collapses continue from one target to the next.
+ * Vertices on the boundary (edges of a single triangle) are never moved or collapsed away, so a mesh cut
+ * out of a larger one keeps its border exactly. Those collapses and the ones that would flip a triangle
+ * are refused, so a level can end up with more triangles than asked for.
+ * @param mesh The full mesh
+ * @param targets Triangle counts to stop at, in decreasing order
+ * @param out Receives one mesh per target
+ * @param errors Receives the object space error of every output mesh
+ */
+void SimplifyMesh(const Mesh& mesh, const std::vector<size_t>& targets, std::vector<Mesh>& out, std::vector<float>& errors);
+
+/**
+ * @brief Build the levels of a mesh.
+ * @param mesh The full mesh, it becomes levels[0]
+ * @param max_levels Number of levels including the full mesh
+ * @param ratio Triangle count of a level relative to the one before it
+ * @param min_triangles No level gets fewer triangles than this
+ * @param lod Receives the levels
+ */
+void BuildMeshLod(Mesh&& mesh, int max_levels, float ratio, size_t min_triangles, MeshLod& lod);
@@ -0,0 +1,367 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+#include "MeshOptimizer.h"
+#include "Mesh.h"
+
+namespace {
+
+constexpr uint32_t NO_VERTEX = 0xFFFFFFFFu;
+
+/**
+ * @brief Triangles around every vertex, as offsets into one flat list.
+ */
+struct VertexTriangles {
+    std::vector<uint32_t> offsets;      // Triangles of vertex v are list[offsets[v] .. offsets[v + 1])
+    std::vector<uint32_t> list;
+
+    VertexTriangles(const uint32_t* indices, size_t count, size_t vertex_count) {
+        offsets.assign(vertex_count + 1, 0);
+        for (size_t i = 0; i < count; ++i) {
+            ++offsets[indices[i] + 1];
+        }
+        for (size_t v = 0; v < vertex_count; ++v) {
+            offsets[v + 1] += offsets[v];
+        }
+        list.resize(count);
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < count; ++i) {
+            list[fill[indices[i]]++] = (uint32_t)(i / 3);
+        }
+    }
+};
+
+}
+
+double ComputeAcmr(const uint32_t* indices, size_t count, size_t vertex_count, int cache_size) {
+    if (count < 3) {
+        return 0.0;
+    }
+
+    // A vertex is in a FIFO cache if fewer than cache_size misses happened since it was put in
+    std::vector<size_t> inserted(vertex_count, 0);
+    size_t misses = 0;
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t v = indices[i];
+        if (inserted[v] == 0 || misses - inserted[v] >= (size_t)cache_size) {
+            ++misses;
+            inserted[v] = misses;
+        }
+    }
+    return (double)misses / (double)(count / 3);
+}
+
+void TipsifyOrder(const uint32_t* indices, size_t count, size_t vertex_count, int cache_size,
+                  std::vector<uint32_t>& out, std::vector<size_t>& cluster_starts) {
+    const size_t tri_count = count / 3;
+    out.clear();
+    out.reserve(tri_count * 3);
+    cluster_starts.clear();
+
+    VertexTriangles adjacency(indices, count, vertex_count);
+    std::vector<uint32_t> live(vertex_count);
+    for (size_t v = 0; v < vertex_count; ++v) {
+        live[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+    }
+
+    std::vector<size_t> cache_time(vertex_count, 0);
+    std::vector<char> emitted(tri_count, 0);
+    std::vector<uint32_t> dead_end;     // Recently used vertices, a cheap place to restart from
+    std::vector<uint32_t> candidates;
+    size_t time = (size_t)cache_size + 1;
+    size_t cursor = 0;                  // Scan position for the last resort restart
+
+    // Start at the first vertex that is used at all
+    uint32_t fan = NO_VERTEX;
+    while (cursor < vertex_count && live[cursor] == 0) {
+        ++cursor;
+    }
+    if (cursor < vertex_count) {
+        fan = (uint32_t)cursor;
+        cluster_starts.push_back(0);
+    }
+
+    while (fan != NO_VERTEX) {
+        // Emit every remaining triangle around the fanning vertex
+        candidates.clear();
+        for (uint32_t k = adjacency.offsets[fan]; k < adjacency.offsets[fan + 1]; ++k) {
+            uint32_t t = adjacency.list[k];
+            if (emitted[t]) {
+                continue;
+            }
+            emitted[t] = 1;
+            for (int c = 0; c < 3; ++c) {
+                uint32_t v = indices[t * 3 + c];
+                out.push_back(v);
+                dead_end.push_back(v);
+                candidates.push_back(v);
+                --live[v];
+                if (time - cache_time[v] > (size_t)cache_size) {
+                    cache_time[v] = time++;
+                }
+            }
+        }
+
+        // Next fan: the oldest candidate that is still in cache after its remaining triangles are emitted
+        uint32_t next = NO_VERTEX;
+        size_t best = 0;
+        for (uint32_t v : candidates) {
+            if (live[v] == 0) {
+                continue;
+            }
+            size_t age = time - cache_time[v];
+            size_t priority = age + 2 * live[v] <= (size_t)cache_size ? age : 0;
+            if (priority > best) {
+                best = priority;
+                next = v;
+            }
+        }
+
+        if (next == NO_VERTEX) {
+            // Dead end: the cache is lost, so a new cluster starts here
+            while (!dead_end.empty() && next == NO_VERTEX) {
+                uint32_t v = dead_end.back();
+                dead_end.pop_back();
+                if (live[v] > 0) {
+                    next = v;
+                }
+            }
+            while (next == NO_VERTEX && cursor < vertex_count) {
+                if (live[cursor] > 0) {
+                    next = (uint32_t)cursor;
+                }
+                ++cursor;
+            }
+            if (next != NO_VERTEX) {
+                cluster_starts.push_back(out.size() / 3);
+            }
+        }
+        fan = next;
+    }
+}
+
+void OptimizeMesh(Mesh& mesh, int cache_size, MeshOptimizeStats* stats) {
+    auto start = std::chrono::steady_clock::now();
+    const size_t vertex_count = mesh.positions.Size();
+    const size_t tri_count = mesh.TriangleCount();
+    const uint32_t* indices = mesh.indices.Data();
+
+    double acmr_before = ComputeAcmr(indices, mesh.indices.Size(), vertex_count, cache_size);
+
+    // 1. Cache order
+    std::vector<uint32_t> tipsy;
+    std::vector<size_t> cluster_starts;
+    TipsifyOrder(indices, mesh.indices.Size(), vertex_count, cache_size, tipsy, cluster_starts);
+    cluster_starts.push_back(tri_count);
+
+    // 2. Overdraw order: a cluster whose area weighted normal points away from the mesh center is on the
+    // outside, and is seen before whatever it covers from almost every direction. Draw those first
+    Vector3d mesh_center = (mesh.bounds_min + mesh.bounds_max) * 0.5f;
+    const size_t cluster_count = cluster_starts.size() - 1;
+    std::vector<float> outwardness(cluster_count);
+    for (size_t c = 0; c < cluster_count; ++c) {
+        Vector3d centroid(0.0f, 0.0f, 0.0f);
+        Vector3d normal(0.0f, 0.0f, 0.0f);
+        float area_sum = 0.0f;
+        for (size_t t = cluster_starts[c]; t < cluster_starts[c + 1]; ++t) {
+            Vector3d p0 = mesh.positions.Get(tipsy[t * 3]);
+            Vector3d p1 = mesh.positions.Get(tipsy[t * 3 + 1]);
+            Vector3d p2 = mesh.positions.Get(tipsy[t * 3 + 2]);
+            Vector3d n = CrossProduct(p1 - p0, p2 - p0);    // Length is twice the area
+            float area = VectorLength(n);
+            centroid = centroid + (p0 + p1 + p2) * (area / 3.0f);
+            normal = normal + n;
+            area_sum += area;
+        }
+        if (area_sum > 0.0f && VectorLength(normal) > 0.0f) {
+            centroid = centroid / area_sum;
+            outwardness[c] = DotProduct(centroid - mesh_center, NormalizeToNew(normal));
+        }
+    }
+    std::vector<size_t> cluster_order(cluster_count);
+    std::iota(cluster_order.begin(), cluster_order.end(), (size_t)0);
+    std::stable_sort(cluster_order.begin(), cluster_order.end(), [&](size_t a, size_t b) {
+        return outwardness[a] > outwardness[b];
+    });
+
+    std::vector<uint32_t> ordered;
+    ordered.reserve(tipsy.size());
+    for (size_t c : cluster_order) {
+        ordered.insert(ordered.end(), tipsy.begin() + cluster_starts[c] * 3, tipsy.begin() + cluster_starts[c + 1] * 3);
+    }
+
+    // 3. Fetch order: number the vertices by first use, unused ones are dropped
+    std::vector<uint32_t> remap(vertex_count, NO_VERTEX);
+    VertexStreamSoA new_positions;
+    for (uint32_t& v : ordered) {
+        if (remap[v] == NO_VERTEX) {
+            remap[v] = (uint32_t)new_positions.Size();
+            new_positions.PushBack(mesh.positions.Get(v));
+        }
+        v = remap[v];
+    }
+
+    mesh.SetGeometry(std::move(new_positions), std::move(ordered));
+
+    if (stats) {
+        stats->cache_size = cache_size;
+        stats->acmr_before = acmr_before;
+        stats->acmr_after = ComputeAcmr(mesh.indices.Data(), mesh.indices.Size(), mesh.positions.Size(), cache_size);
+        stats->clusters = cluster_count;
+        stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+void BuildMeshlets(Mesh& mesh, size_t max_triangles, size_t max_vertices) {
+    const size_t vertex_count = mesh.positions.Size();
+    const size_t tri_count = mesh.TriangleCount();
+    const uint32_t* indices = mesh.indices.Data();
+    VertexTriangles adjacency(indices, mesh.indices.Size(), vertex_count);
+
+    // Grow the meshlets. A vertex belongs to the current meshlet when its stamp is the meshlet number
+    std::vector<uint32_t> meshlet_of(tri_count, NO_VERTEX);
+    std::vector<uint32_t> vertex_stamp(vertex_count, NO_VERTEX);
+    std::vector<uint32_t> frontier;
+    std::vector<size_t> meshlet_sizes;
+    size_t seed = 0;
+    for (uint32_t id = 0;; ++id) {
+        while (seed < tri_count && meshlet_of[seed] != NO_VERTEX) {
+            ++seed;
+        }
+        if (seed == tri_count) {
+            break;
+        }
+
+        size_t tris = 0, verts = 0;
+        frontier.assign(1, (uint32_t)seed);
+        for (size_t next = 0; next < frontier.size() && tris < max_triangles; ++next) {
+            uint32_t t = frontier[next];
+            if (meshlet_of[t] != NO_VERTEX) {
+                continue;
+            }
+            size_t new_verts = 0;
+            for (int c = 0; c < 3; ++c) {
+                new_verts += vertex_stamp[indices[t * 3 + c]] != id;
+            }
+            if (verts + new_verts > max_vertices) {
+                continue;
+            }
+
+            meshlet_of[t] = id;
+            ++tris;
+            verts += new_verts;
+            for (int c = 0; c < 3; ++c) {
+                uint32_t v = indices[t * 3 + c];
+                if (vertex_stamp[v] == id) {
+                    continue;
+                }
+                vertex_stamp[v] = id;
+                for (uint32_t k = adjacency.offsets[v]; k < adjacency.offsets[v + 1]; ++k) {
+                    if (meshlet_of[adjacency.list[k]] == NO_VERTEX) {
+                        frontier.push_back(adjacency.list[k]);
+                    }
+                }
+            }
+        }
+        meshlet_sizes.push_back(tris);
+    }
+
+    // Build the hierarchy over the boxes of the meshlets, one meshlet per leaf
+    const size_t meshlet_count = meshlet_sizes.size();
+    std::vector<BvhItem> boxes(meshlet_count);
+    for (BvhItem& box : boxes) {
+        for (int a = 0; a < 3; ++a) {
+            box.bounds_min[a] = 3.4e38f;
+            box.bounds_max[a] = -3.4e38f;
+        }
+    }
+    for (size_t t = 0; t < tri_count; ++t) {
+        BvhItem& box = boxes[meshlet_of[t]];
+        for (int c = 0; c < 3; ++c) {
+            Vector3d p = mesh.positions.Get(indices[t * 3 + c]);
+            const float coords[3] = { p.x, p.y, p.z };
+            for (int a = 0; a < 3; ++a) {
+                box.bounds_min[a] = std::min(box.bounds_min[a], coords[a]);
+                box.bounds_max[a] = std::max(box.bounds_max[a], coords[a]);
+            }
+        }
+    }
+    std::vector<BvhNode> bvh;
+    std::vector<uint32_t> leaf_order;
+    BuildBvh(boxes, 1, bvh, leaf_order);
+
+    // Lay the meshlets out in leaf order so every node covers a run of them, triangles in their old order within each
+    std::vector<uint32_t> slot_of(meshlet_count);
+    for (size_t k = 0; k < meshlet_count; ++k) {
+        slot_of[leaf_order[k]] = (uint32_t)k;
+    }
+    std::vector<size_t> meshlet_begin(meshlet_count + 1, 0);
+    for (size_t k = 0; k < meshlet_count; ++k) {
+        meshlet_begin[k + 1] = meshlet_begin[k] + meshlet_sizes[leaf_order[k]];
+    }
+    std::vector<size_t> fill(meshlet_begin.begin(), meshlet_begin.end() - 1);
+    std::vector<uint32_t> ordered(tri_count * 3);
+    for (size_t t = 0; t < tri_count; ++t) {
+        size_t dst = fill[slot_of[meshlet_of[t]]]++;
+        for (int c = 0; c < 3; ++c) {
+            ordered[dst * 3 + c] = indices[t * 3 + c];
+        }
+    }
+
+    std::vector<uint32_t> remap(vertex_count, NO_VERTEX);
+    VertexStreamSoA new_positions;
+    for (uint32_t& v : ordered) {
+        if (remap[v] == NO_VERTEX) {
+            remap[v] = (uint32_t)new_positions.Size();
+            new_positions.PushBack(mesh.positions.Get(v));
+        }
+        v = remap[v];
+    }
+    mesh.SetGeometry(std::move(new_positions), std::move(ordered));
+
+    // Bounding sphere around the box of the corners, normal cone around the average normal
+    std::vector<Meshlet> meshlets(meshlet_count);
+    for (size_t m = 0; m < meshlet_count; ++m) {
+        Meshlet& ml = meshlets[m];
+        ml.triangle_begin = (uint32_t)meshlet_begin[m];
+        ml.triangle_count = (uint32_t)(meshlet_begin[m + 1] - meshlet_begin[m]);
+
+        Vector3d lo = mesh.Corner(ml.triangle_begin, 0), hi = lo;
+        Vector3d axis(0.0f, 0.0f, 0.0f);
+        for (uint32_t t = ml.triangle_begin; t < ml.triangle_begin + ml.triangle_count; ++t) {
+            for (int c = 0; c < 3; ++c) {
+                Vector3d p = mesh.Corner(t, c);
+                lo = { std::min(lo.x, p.x), std::min(lo.y, p.y), std::min(lo.z, p.z) };
+                hi = { std::max(hi.x, p.x), std::max(hi.y, p.y), std::max(hi.z, p.z) };
+            }
+            axis = axis + mesh.normals.Get(t);
+        }
+        Vector3d center = (lo + hi) * 0.5f;
+        float radius = 0.0f;
+        for (uint32_t t = ml.triangle_begin; t < ml.triangle_begin + ml.triangle_count; ++t) {
+            for (int c = 0; c < 3; ++c) {
+                radius = std::max(radius, VectorLength(mesh.Corner(t, c) - center));
+            }
+        }
+        ml.center[0] = center.x;
+        ml.center[1] = center.y;
+        ml.center[2] = center.z;
+        ml.radius = radius;
+
+        // The cone is as wide as the normal furthest from the axis, past 90 degrees there is no cone
+        float min_dot = -1.0f;
+        if (VectorLength(axis) > 0.0f) {
+            axis = NormalizeToNew(axis);
+            min_dot = 1.0f;
+            for (uint32_t t = ml.triangle_begin; t < ml.triangle_begin + ml.triangle_count; ++t) {
+                min_dot = std::min(min_dot, DotProduct(axis, mesh.normals.Get(t)));
+            }
+        }
+        ml.cone_axis[0] = axis.x;
+        ml.cone_axis[1] = axis.y;
+        ml.cone_axis[2] = axis.z;
+        ml.cone_sin = min_dot > 0.0f ? std::sqrt(1.0f - min_dot * min_dot) : 2.0f;
+    }
+    mesh.SetMeshlets(std::move(meshlets), std::move(bvh));
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct Mesh;
+
+/*
+ * Offline reordering of a mesh, so the same triangles cost less to draw:
+ *   1. Tipsify (Sander, Nehab and Barczak, 2007) orders triangles so that a vertex is reused while it is
+ *      still in a small post-transform cache.
+ *   2. The clusters Tipsify leaves behind (it starts a new one whenever the cache is lost) are sorted so
+ *      that outward facing parts of the mesh come first, which draws front to back for most views.
+ *   3. Vertices are renumbered in the order the triangles first use them, so fetches walk memory forward.
+ * The result is the same surface, only the order of triangles and vertices changes.
+ */
+
+/**
+ * @brief Before / after numbers of OptimizeMesh.
+ */
+struct MeshOptimizeStats {
+    int cache_size = 0;         // FIFO size the ACMR was measured with
+    double acmr_before = 0.0;   // Average cache miss ratio: transformed vertices per triangle, 0.5 is ideal, 3 is worst
+    double acmr_after = 0.0;
+    size_t clusters = 0;        // Clusters sorted for overdraw
+    double seconds = 0.0;
+};
+
+/**
+ * @brief Average cache miss ratio of an index buffer with a FIFO post-transform cache.
+ * @param indices Three indices per triangle
+ * @param count Number of indices
+ * @param vertex_count Number of vertices the indices refer to
+ * @param cache_size Entries of the simulated cache
+ * @return Vertex transforms per triangle
+ */
+double ComputeAcmr(const uint32_t* indices, size_t count, size_t vertex_count, int cache_size);
+
+/**
+ * @brief Tipsify triangle order.
+ * @param indices Three indices per triangle
+ * @param count Number of indices
+ * @param vertex_count Number of vertices the indices refer to
+ * @param cache_size Entries of the target cache
+ * @param out Receives the reordered indices
+ * @param cluster_starts Receives the first triangle of every cluster, beginning with 0
+ */
+void TipsifyOrder(const uint32_t* indices, size_t count, size_t vertex_count, int cache_size,
+                  std::vector<uint32_t>& out, std::vector<size_t>& cluster_starts);
+
+/**
+ * @brief Reorder the triangles and vertices of a mesh for cache reuse, overdraw and fetch locality.
+ * Unused vertices are dropped, normals and bounds are recomputed.
+ * @param mesh The mesh, it ends up owning its arrays even if it was mapped
+ * @param cache_size Entries of the target post-transform cache
+ * @param stats Receives ACMR before and after, may be nullptr
+ */
+void OptimizeMesh(Mesh& mesh, int cache_size = 16, MeshOptimizeStats* stats = nullptr);
+
+/**
+ * @brief Split a mesh into meshlets and reorder its triangles so every meshlet is contiguous.
+ * Meshlets grow from a seed triangle to its neighbours breadth first, so they stay compact. Triangles
+ * keep their relative order inside a meshlet and vertices are renumbered by first use again, so the
+ * cache order from OptimizeMesh is mostly kept. Normals and bounds are recomputed.
+ * The meshlets themselves are ordered by a bounding volume hierarchy over their boxes (mesh.meshlet_bvh),
+ * so every node of it covers a run of meshlets and with them a run of triangles.
+ * @param mesh The mesh, it ends up owning its arrays even if it was mapped
+ * @param max_triangles Largest number of triangles in a meshlet
+ * @param max_vertices Largest number of distinct vertices in a meshlet
+ */
+void BuildMeshlets(Mesh& mesh, size_t max_triangles = 124, size_t max_vertices = 96);
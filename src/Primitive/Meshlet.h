@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * @brief A small cluster of neighbouring triangles that is culled as a whole.
+ * The triangles of a meshlet are contiguous in the index buffer of its mesh. The bounding sphere rejects
+ * it against the frustum, the normal cone rejects it when every triangle in it faces away from the camera.
+ * It is plain data so it can be written to and mapped from the mesh cache as it is.
+ */
+struct Meshlet {
+    uint32_t triangle_begin;    // First triangle
+    uint32_t triangle_count;    // Number of triangles
+    float center[3];            // Bounding sphere of the corners, object space
+    float radius;
+    float cone_axis[3];         // Unit average direction of the face normals
+    float cone_sin;             // Sine of the widest angle between a normal and the axis, above 1 when there is no cone
+};
+
+/**
+ * @brief Whether every triangle of a meshlet faces away from a point, so none of them can be seen from it.
+ * A triangle faces away when dot(normal, corner - eye) >= 0. That holds for every normal within the cone
+ * and every point within the sphere when the direction to the sphere is inside the cone of directions
+ * that are at least 90 degrees away from all normals, enlarged by the radius.
+ * @param m The meshlet
+ * @param eye_x Eye position in the object space of the mesh
+ * @param eye_y
+ * @param eye_z
+ * @return true if the whole meshlet can be skipped
+ */
+inline bool MeshletBackfacing(const Meshlet& m, float eye_x, float eye_y, float eye_z) {
+    float dx = m.center[0] - eye_x;
+    float dy = m.center[1] - eye_y;
+    float dz = m.center[2] - eye_z;
+    float along = dx * m.cone_axis[0] + dy * m.cone_axis[1] + dz * m.cone_axis[2];
+    float dist2 = dx * dx + dy * dy + dz * dz;
+
+    // along >= sin * |d| + r * (1 + sin), squared with care for the signs
+    float rhs = m.radius * (1.0f + m.cone_sin);
+    if (along <= rhs || m.cone_sin > 1.0f) {
+        return false;
+    }
+    float left = along - rhs;
+    return left * left >= m.cone_sin * m.cone_sin * dist2;
+}
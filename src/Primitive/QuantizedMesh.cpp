@@ -0,0 +1,38 @@
+#include <algorithm>
+#include <cmath>
+#include "QuantizedMesh.h"
+#include "Mesh.h"
+
+void QuantizeMesh(const Mesh& mesh, QuantizedMesh& out) {
+    const size_t vertex_count = mesh.positions.Size();
+    out.bounds_min = mesh.bounds_min;
+    out.bounds_max = mesh.bounds_max;
+
+    // A flat axis gets a zero step, every vertex on it decodes to bounds_min
+    const float levels = 65535.0f;
+    Vector3d extent = mesh.bounds_max - mesh.bounds_min;
+    out.step = { extent.x / levels, extent.y / levels, extent.z / levels };
+
+    auto quantize = [&](float value, float min, float size) {
+        if (size <= 0.0f) {
+            return (uint16_t)0;
+        }
+        float q = std::round((value - min) / size * levels);
+        return (uint16_t)std::min(std::max(q, 0.0f), levels);
+    };
+
+    out.positions.Resize(vertex_count);
+    for (size_t v = 0; v < vertex_count; ++v) {
+        out.positions.x[v] = quantize(mesh.positions.x[v], mesh.bounds_min.x, extent.x);
+        out.positions.y[v] = quantize(mesh.positions.y[v], mesh.bounds_min.y, extent.y);
+        out.positions.z[v] = quantize(mesh.positions.z[v], mesh.bounds_min.z, extent.z);
+    }
+
+    out.indices.assign(mesh.indices.begin(), mesh.indices.end());
+    out.normals.resize(mesh.TriangleCount());
+    for (size_t t = 0; t < out.normals.size(); ++t) {
+        out.normals[t] = OctEncodeNormal(mesh.normals.Get(t));
+    }
+    out.meshlets.assign(mesh.meshlets.begin(), mesh.meshlets.end());
+    out.meshlet_bvh.assign(mesh.meshlet_bvh.begin(), mesh.meshlet_bvh.end());
+}
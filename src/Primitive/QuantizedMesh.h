@@ -0,0 +1,124 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "Meshlet.h"
+#include "../Maths/Geometry/Bvh.h"
+#include "../Maths/Matrix/Mat4x4.h"
+#include "../Maths/Matrix/TransformBatch.h"
+
+struct Mesh;
+
+/**
+ * @brief A compressed copy of a Mesh for scenes that do not fit in memory as floats.
+ * Positions are quantized to 16 bits per axis inside the bounding box of the mesh (6 bytes per vertex
+ * instead of 12, or 16 as a Vector3d), and face normals are octahedral encoded in 16 bits (2 bytes instead
+ * of 12). The precision is one 65535th of the box on every axis.
+ *
+ * Nothing is decompressed up front: the pipeline transforms the integers directly with the dequantization
+ * folded into the vertex matrix, and decodes a normal only for the triangles it looks at.
+ */
+struct QuantizedMesh {
+    QuantizedStreamSoA positions;   // Unique vertices, quantized inside the bounding box
+    std::vector<uint32_t> indices;  // Three indices into positions per triangle
+    std::vector<uint16_t> normals;  // Octahedral face normals, one per triangle (see OctEncodeNormal)
+    std::vector<Meshlet> meshlets;  // Same as the source mesh, in object space
+    std::vector<BvhNode> meshlet_bvh;   // The hierarchy over them, also copied
+    Vector3d bounds_min;            // Object space bounding box, quantized value 0
+    Vector3d bounds_max;
+    Vector3d step;                  // Object space size of one quantization step on every axis
+
+    /**
+     * @brief Number of triangles.
+     * @return The triangle count
+     */
+    size_t TriangleCount() const { return indices.size() / 3; }
+
+    /**
+     * @brief Decode one vertex.
+     * @param v Index of the vertex
+     * @return The vertex in object space
+     */
+    Vector3d Position(size_t v) const {
+        return { bounds_min.x + positions.x[v] * step.x, bounds_min.y + positions.y[v] * step.y, bounds_min.z + positions.z[v] * step.z };
+    }
+
+    /**
+     * @brief The matrix that takes quantized coordinates to object space, put it in front of the world matrix.
+     * @return The dequantization matrix
+     */
+    Mat4x4 Dequantization() const {
+        Mat4x4 matrix;
+        matrix.m[0][0] = step.x;
+        matrix.m[1][1] = step.y;
+        matrix.m[2][2] = step.z;
+        matrix.m[3][0] = bounds_min.x;
+        matrix.m[3][1] = bounds_min.y;
+        matrix.m[3][2] = bounds_min.z;
+        matrix.m[3][3] = 1.0f;
+        return matrix;
+    }
+
+    /**
+     * @brief Memory used by the arrays.
+     * @return Bytes
+     */
+    size_t Bytes() const {
+        return positions.Size() * 3 * sizeof(uint16_t) + indices.size() * sizeof(uint32_t)
+             + normals.size() * sizeof(uint16_t) + meshlets.size() * sizeof(Meshlet)
+             + meshlet_bvh.size() * sizeof(BvhNode);
+    }
+};
+
+/**
+ * @brief Compress a mesh, the meshlets and their hierarchy are kept as they are.
+ * @param mesh The source mesh
+ * @param out Receives the compressed copy
+ */
+void QuantizeMesh(const Mesh& mesh, QuantizedMesh& out);
+
+/* ---------------------------------
+ ------- Octahedral normals --------
+ --------------------------------- */
+
+/**
+ * @brief Pack a unit vector in 16 bits. The sphere is projected onto the octahedron |x| + |y| + |z| = 1,
+ * and the lower half is folded over the upper one so the whole octahedron unfolds into a square.
+ * The two coordinates in that square are stored as signed 8-bit values, x in the low byte.
+ * @param n The unit vector
+ * @return The packed vector
+ */
+inline uint16_t OctEncodeNormal(const Vector3d& n) {
+    float l1 = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+    if (l1 == 0.0f) {
+        return 0;
+    }
+    float u = n.x / l1;
+    float v = n.y / l1;
+    if (n.z < 0.0f) {
+        float fu = (1.0f - std::fabs(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+        float fv = (1.0f - std::fabs(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+        u = fu;
+        v = fv;
+    }
+    int8_t qu = (int8_t)std::lround(u * 127.0f);
+    int8_t qv = (int8_t)std::lround(v * 127.0f);
+    return (uint16_t)((uint8_t)qu | ((uint16_t)(uint8_t)qv << 8));
+}
+
+/**
+ * @brief Unpack a vector packed by OctEncodeNormal.
+ * @param packed The packed vector
+ * @return The unit vector
+ */
+inline Vector3d OctDecodeNormal(uint16_t packed) {
+    float u = (float)(int8_t)(packed & 0xFF) / 127.0f;
+    float v = (float)(int8_t)(packed >> 8) / 127.0f;
+    float z = 1.0f - std::fabs(u) - std::fabs(v);
+
+    // Unfold the lower half
+    float fold = std::fmax(-z, 0.0f);
+    u += u >= 0.0f ? -fold : fold;
+    v += v >= 0.0f ? -fold : fold;
+    return NormalizeToNew({ u, v, z });
+}
@@ -0,0 +1,155 @@
+#include <cmath>
+#include "Clipping.h"
+#include "../Platform/CpuFeatures.h"
+
+namespace {
+
+/**
+ * @brief Shared part of both clippers: sort the corners by the sign of their distance and build the output.
+ * @param d Signed distances of the three corners, positive is inside
+ * @param in_tri The input triangle
+ * @param intersect Callable returning the crossing point between an inside and an outside corner
+ */
+template <typename Intersect>
+int ClipByDistance(const float d[3], const Triangle& in_tri, Triangle& out_tri_1, Triangle& out_tri_2, Intersect intersect) {
+    // Create two temporary storage arrays to classify points either side of plane
+    // If distance sign is positive, point lies on "inside" of plane
+    const Vector3d* inside_pts[3]{};
+    const Vector3d* outside_pts[3]{};
+    float inside_d[3]{}, outside_d[3]{};
+
+    int cnt_inside = 0, cnt_outside = 0;
+
+    for (int i = 0; i < 3; ++i) {
+        if (d[i] >= 0) {
+            inside_d[cnt_inside] = d[i];
+            inside_pts[cnt_inside++] = &in_tri.pts[i];
+        }
+        else {
+            outside_d[cnt_outside] = d[i];
+            outside_pts[cnt_outside++] = &in_tri.pts[i];
+        }
+    }
+
+    // 4 possible case
+    if (cnt_inside == 0) {
+        // The triangle is outside of the frustum
+        return 0;
+    }
+
+    if (cnt_inside == 3) {
+        // All points line inside of the frustum
+        out_tri_1 = in_tri;
+        return 1;
+    }
+
+    if (cnt_inside == 1 && cnt_outside == 2) {
+        // Triangle should be clipped. As two points lie outside
+        // the plane, the triangle simply becomes a smaller triangle
+        out_tri_1.col = in_tri.col;
+        out_tri_1.sym = in_tri.sym;
+
+        out_tri_1.pts[0] = *inside_pts[0];
+        out_tri_1.pts[1] = intersect(*inside_pts[0], inside_d[0], *outside_pts[0], outside_d[0]);
+        out_tri_1.pts[2] = intersect(*inside_pts[0], inside_d[0], *outside_pts[1], outside_d[1]);
+        return 1;
+    }
+
+    // cnt_inside == 2 && cnt_outside == 1, make quad to be two triangles
+    out_tri_1.col = in_tri.col;
+    out_tri_1.sym = in_tri.sym;
+    out_tri_2.col = in_tri.col;
+    out_tri_2.sym = in_tri.sym;
+
+    out_tri_1.pts[0] = *inside_pts[0];
+    out_tri_1.pts[1] = *inside_pts[1];
+    out_tri_1.pts[2] = intersect(*inside_pts[0], inside_d[0], *outside_pts[0], outside_d[0]);
+
+    out_tri_2.pts[0] = *inside_pts[1];
+    out_tri_2.pts[1] = out_tri_1.pts[2];
+    out_tri_2.pts[2] = intersect(*inside_pts[1], inside_d[1], *outside_pts[0], outside_d[0]);
+    return 2;
+}
+
+/**
+ * @brief Reference version in plain float math, no SIMD.
+ */
+int ClipAgainstPlaneScalar(const Vector3d& plane_p, Vector3d normal, const Triangle& in_tri, Triangle& out_tri_1, Triangle& out_tri_2) {
+    // Normal should be normalized
+    float l = std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+    normal.x /= l;
+    normal.y /= l;
+    normal.z /= l;
+
+    // Return signed shortest distance from point to plane, plane normal must be normalized
+    float plane_d = normal.x * plane_p.x + normal.y * plane_p.y + normal.z * plane_p.z;
+    float d[3];
+    for (int i = 0; i < 3; ++i) {
+        const Vector3d& p = in_tri.pts[i];
+        d[i] = normal.x * p.x + normal.y * p.y + normal.z * p.z - plane_d;
+    }
+
+    return ClipByDistance(d, in_tri, out_tri_1, out_tri_2,
+        [](const Vector3d& in_pt, float in_d, const Vector3d& out_pt, float out_d) {
+            // Same t as IntersectPlane, both distances are already relative to the plane
+            float t = in_d / (in_d - out_d);
+            return Vector3d{ in_pt.x + (out_pt.x - in_pt.x) * t,
+                             in_pt.y + (out_pt.y - in_pt.y) * t,
+                             in_pt.z + (out_pt.z - in_pt.z) * t };
+        });
+}
+
+/**
+ * @brief Version on Vec4, so SSE2 on x86 and NEON on ARM.
+ */
+int ClipAgainstPlaneSimd128(const Vector3d& plane_p, Vector3d normal, const Triangle& in_tri, Triangle& out_tri_1, Triangle& out_tri_2) {
+    // Normal should be normalized
+    Normalize(normal);
+
+    // Return signed shortest distance from point to plane, plane normal must be normalized
+    float plane_d = DotProduct(normal, plane_p);
+    float d[3];
+    for (int i = 0; i < 3; ++i) {
+        d[i] = DotProduct(normal, in_tri.pts[i]) - plane_d;
+    }
+
+    return ClipByDistance(d, in_tri, out_tri_1, out_tri_2,
+        [&](const Vector3d& in_pt, float, const Vector3d& out_pt, float) {
+            return IntersectPlane(plane_p, normal, in_pt, out_pt);
+        });
+}
+
+using ClipAgainstPlaneFunc = int (*)(const Vector3d&, Vector3d, const Triangle&, Triangle&, Triangle&);
+
+/**
+ * @brief Pick the kernel for the active CPU tier, done once. Wider units do not help on a single triangle,
+ * so everything from SSE2 up shares the 4 wide version.
+ */
+ClipAgainstPlaneFunc SelectClipAgainstPlane() {
+    return ActiveCpuLevel() == CpuLevel::Scalar ? ClipAgainstPlaneScalar : ClipAgainstPlaneSimd128;
+}
+
+}
+
+int ClipAgainstPlane(const Vector3d& plane_p, Vector3d normal, const Triangle& in_tri, Triangle& out_tri_1, Triangle& out_tri_2) {
+    static const ClipAgainstPlaneFunc kernel = SelectClipAgainstPlane();
+    return kernel(plane_p, normal, in_tri, out_tri_1, out_tri_2);
+}
+
+int ClipAgainstNearW(float near_w, const Triangle& in_tri, Triangle& out_tri_1, Triangle& out_tri_2) {
+    float d[3];
+    for (int i = 0; i < 3; ++i) {
+        d[i] = in_tri.pts[i].w - near_w;
+    }
+
+    return ClipByDistance(d, in_tri, out_tri_1, out_tri_2,
+        [](const Vector3d& in_pt, float in_d, const Vector3d& out_pt, float out_d) {
+            // Interpolate x y z and w together, the crossing point has w == near_w
+            float t = in_d / (in_d - out_d);
+            Vec4 a = ToVec4(in_pt);
+            Vec4 p = a + (ToVec4(out_pt) - a) * t;
+            Vector3d res;
+            Vec4Store(&res.x, p);
+            return res;
+        });
+}
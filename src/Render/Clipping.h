@@ -0,0 +1,24 @@
+#pragma once
+#include "../Primitive/Triangle.h"
+
+/**
+ * @brief This performs clipping triangles, checking whether the triangle should be renderred or not, or render parts of them
+ * @param plane_p The frustum boarder plane point
+ * @param normal The normal of the plane
+ * @param in_tri The input triangle
+ * @param out_tri_1 The placeholder for output
+ * @param out_tri_2 The other placeholder
+ * @return Integer representing how many triangles are output
+ */
+int ClipAgainstPlane(const Vector3d& plane_p, Vector3d normal, const Triangle& in_tri, Triangle& out_tri_1, Triangle& out_tri_2);
+
+/**
+ * @brief Clip a clip space triangle against the near plane w = near_w, before the divide by w.
+ * All four components are interpolated, so the result is the same as clipping in view space and projecting afterwards.
+ * @param near_w The view space depth of the near clipping plane
+ * @param in_tri The input triangle in clip space
+ * @param out_tri_1 The placeholder for output
+ * @param out_tri_2 The other placeholder
+ * @return Integer representing how many triangles are output
+ */
+int ClipAgainstNearW(float near_w, const Triangle& in_tri, Triangle& out_tri_1, Triangle& out_tri_2);
@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <cmath>
+#include "DepthPyramid.h"
+#include "Rasterizer.h"
+
+namespace {
+
+/**
+ * @brief What the span callback needs to write one occluder: its depth plane over the screen.
+ */
+struct OccluderTarget {
+    float* depth;           // The base level
+    int width;
+    float z0, x0, y0;       // Depth at one corner
+    float dz_dx, dz_dy;     // Depth change per pixel along x and y
+    float z_min, z_max;     // Depth range of the corners, the plane is clamped to it
+};
+
+/**
+ * @brief Span callback, keeps the nearer of the stored depth and the occluder depth at each pixel center.
+ */
+void WriteOccluderSpan(void* user, const RasterSpan& span) {
+    const OccluderTarget* t = static_cast<const OccluderTarget*>(user);
+    float* row = t->depth + span.y * t->width;
+    float z = t->z0 + ((float)span.x_begin + 0.5f - t->x0) * t->dz_dx + ((float)span.y + 0.5f - t->y0) * t->dz_dy;
+    for (int x = span.x_begin; x < span.x_end; ++x, z += t->dz_dx) {
+        float d = std::min(std::max(z, t->z_min), t->z_max);
+        row[x] = std::min(row[x], d);
+    }
+}
+
+}
+
+void DepthPyramid::Clear(int width, int height) {
+    width_ = std::max(1, width);
+    height_ = std::max(1, height);
+    if (levels_.empty() || levels_[0].width != width_ || levels_[0].height != height_) {
+        // Halve until one texel is left, rounding up so the last row and column are always covered
+        levels_.clear();
+        int w = width_, h = height_;
+        for (;;) {
+            levels_.push_back({ w, h, std::vector<float>((size_t)w * h) });
+            if (w == 1 && h == 1) {
+                break;
+            }
+            w = (w + 1) / 2;
+            h = (h + 1) / 2;
+        }
+    }
+    std::fill(levels_[0].depth.begin(), levels_[0].depth.end(), FAR_DEPTH);
+    has_occluders_ = false;
+    ready_ = false;
+}
+
+void DepthPyramid::AddOccluder(const Triangle& tri) {
+    if (levels_.empty()) {
+        return;
+    }
+
+    // Depth after the divide is affine in screen space, so one plane gives it at every pixel
+    const Vector3d& a = tri.pts[0];
+    const Vector3d& b = tri.pts[1];
+    const Vector3d& c = tri.pts[2];
+    float e1x = b.x - a.x, e1y = b.y - a.y, e1z = b.z - a.z;
+    float e2x = c.x - a.x, e2y = c.y - a.y, e2z = c.z - a.z;
+    float det = e1x * e2y - e2x * e1y;
+    if (std::fabs(det) < 1e-6f) {
+        return;
+    }
+
+    OccluderTarget target;
+    target.depth = levels_[0].depth.data();
+    target.width = width_;
+    target.x0 = a.x;
+    target.y0 = a.y;
+    target.z0 = a.z;
+    target.dz_dx = (e1z * e2y - e2z * e1y) / det;
+    target.dz_dy = (e1x * e2z - e2x * e1z) / det;
+    target.z_min = std::min({ a.z, b.z, c.z });
+    target.z_max = std::max({ a.z, b.z, c.z });
+
+    Fixed28_4 x[3], y[3];
+    for (int i = 0; i < 3; ++i) {
+        x[i] = ToFixed28_4(tri.pts[i].x);
+        y[i] = ToFixed28_4(tri.pts[i].y);
+    }
+    FillTriangleFixed(x, y, width_, height_, &WriteOccluderSpan, &target);
+    has_occluders_ = true;
+    ready_ = false;
+}
+
+void DepthPyramid::Build() {
+    for (size_t l = 1; l < levels_.size(); ++l) {
+        const Level& src = levels_[l - 1];
+        Level& dst = levels_[l];
+        for (int y = 0; y < dst.height; ++y) {
+            // An odd last row or column is paired with itself
+            const float* row0 = src.depth.data() + (size_t)(y * 2) * src.width;
+            const float* row1 = src.depth.data() + (size_t)std::min(y * 2 + 1, src.height - 1) * src.width;
+            float* out = dst.depth.data() + (size_t)y * dst.width;
+            for (int x = 0; x < dst.width; ++x) {
+                int x0 = x * 2, x1 = std::min(x * 2 + 1, src.width - 1);
+                out[x] = std::max(std::max(row0[x0], row0[x1]), std::max(row1[x0], row1[x1]));
+            }
+        }
+    }
+    ready_ = has_occluders_;
+}
+
+bool DepthPyramid::Occluded(float min_x, float min_y, float max_x, float max_y, float min_depth) const {
+    if (!ready_) {
+        return false;
+    }
+
+    // Every pixel the rectangle touches, the part off screen cannot be seen anyway
+    int x0 = std::max(0, (int)std::floor(min_x));
+    int y0 = std::max(0, (int)std::floor(min_y));
+    int x1 = std::min(width_ - 1, (int)std::floor(max_x));
+    int y1 = std::min(height_ - 1, (int)std::floor(max_y));
+    if (x0 > x1 || y0 > y1) {
+        return false;
+    }
+
+    // Go up until the rectangle spans at most 4x4 texels
+    size_t level = 0;
+    while (level + 1 < levels_.size() && ((x1 - x0) > 3 || (y1 - y0) > 3)) {
+        x0 >>= 1;
+        y0 >>= 1;
+        x1 >>= 1;
+        y1 >>= 1;
+        ++level;
+    }
+
+    const Level& lv = levels_[level];
+    for (int y = y0; y <= y1; ++y) {
+        for (int x = x0; x <= x1; ++x) {
+            if (lv.depth[(size_t)y * lv.width + x] >= min_depth) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <vector>
+#include "../Primitive/Triangle.h"
+
+/**
+ * @brief A hierarchical depth buffer (Hi-Z) for occlusion culling.
+ *
+ * Occluders are rasterized into a depth buffer at screen resolution, each level above it keeps the farthest
+ * depth of the 2x2 texels below it. A box on screen is then hidden if its nearest depth lies behind the
+ * farthest occluder depth everywhere it covers, which is looked up at the level where the box spans a few
+ * texels, so a test costs the same for a box of any size.
+ *
+ * Depths are z after the perspective divide, as the pipeline outputs them, larger is farther.
+ * Texels no occluder covered hold FAR_DEPTH and hide nothing.
+ */
+class DepthPyramid {
+public:
+    /**
+     * @brief Empty the pyramid and set its size, call before adding the occluders of a frame.
+     * @param width Screen width in pixels
+     * @param height Screen height in pixels
+     */
+    void Clear(int width, int height);
+
+    /**
+     * @brief Rasterize an occluder into the base level, keeping the nearest depth per pixel.
+     * @param tri A screen space triangle, z is the depth after the divide
+     */
+    void AddOccluder(const Triangle& tri);
+
+    /**
+     * @brief Build the levels above the base from it, call once after the occluders are in.
+     */
+    void Build();
+
+    /**
+     * @brief Test a screen space rectangle against the occluders.
+     * @param min_x Left edge in pixels
+     * @param min_y Top edge in pixels
+     * @param max_x Right edge in pixels
+     * @param max_y Bottom edge in pixels
+     * @param min_depth The nearest depth of what the rectangle covers
+     * @return true if every occluder depth under the rectangle is nearer than min_depth
+     */
+    bool Occluded(float min_x, float min_y, float max_x, float max_y, float min_depth) const;
+
+    /**
+     * @brief Whether there is anything to test against, false until Build ran with at least one occluder.
+     */
+    bool Ready() const { return ready_; }
+
+    int Width() const { return width_; }
+    int Height() const { return height_; }
+
+    static constexpr float FAR_DEPTH = 3.4e38f;
+
+private:
+    /**
+     * @brief One level, level 0 is the full resolution.
+     */
+    struct Level {
+        int width, height;
+        std::vector<float> depth;   // Row major, width * height
+    };
+
+    std::vector<Level> levels_;
+    int width_ = 0;
+    int height_ = 0;
+    bool has_occluders_ = false;    // Something was added since Clear
+    bool ready_ = false;            // Build ran after the last occluder
+};
@@ -0,0 +1,470 @@
+#include <algorithm>
+#include <cmath>
+#include "Pipeline.h"
+#include "Clipping.h"
+#include "../Maths/Geometry/Frustum.h"
+#include "../Maths/Geometry/SphereCullBatch.h"
+
+namespace {
+
+/**
+ * @brief How much a world matrix stretches lengths at most, the longest row of its 3x3 part.
+ * Exact for a scale followed by a rotation and a translation, as the worlds are built.
+ */
+float MaxScale(const Mat4x4& world) {
+    float scale2 = 0.0f;
+    for (int r = 0; r < 3; ++r) {
+        const float* row = world.m[r];
+        scale2 = std::max(scale2, row[0] * row[0] + row[1] * row[1] + row[2] * row[2]);
+    }
+    return std::sqrt(scale2);
+}
+
+}
+
+Frustum Pipeline::ViewFrustum() const {
+    return Frustum(view_projection_, near_clip_);
+}
+
+void Pipeline::BeginFrame(const Mat4x4& view, const Mat4x4& projection, float screen_width, float screen_height,
+                          const Vector3d& cam_pos, float near_clip) {
+    Mat4x4 viewport = MakeViewport(screen_width, screen_height);
+    view_projection_ = view * projection;
+    view_projection_viewport_ = view_projection_ * viewport;
+    cam_ = cam_pos;
+    near_clip_ = near_clip;
+    screen_width_ = (int)screen_width;
+    screen_height_ = (int)screen_height;
+    deferred_.clear();
+    draw_count_.clear();
+    ++frame_;
+    light_dir_ = NormalizeToNew({ 0.0f, 1.0f, -1.0f });
+
+    // m[1][1] is cot(fov / 2), so at distance d a length l covers l / d * m[1][1] * height / 2 pixels
+    pixels_per_unit_ = 0.5f * screen_height * projection.m[1][1];
+}
+
+size_t Pipeline::SelectLod(const MeshLod& lod, const Mat4x4& world) const {
+    if (lod.LevelCount() <= 1) {
+        return 0;
+    }
+
+    // Distance from the camera to the nearest point of the bounding sphere, the radius and the errors grow with the scale
+    const Mesh& full = lod.levels[0];
+    float scale = MaxScale(world);
+    Vector3d center = MultiplyMatrixVector((full.bounds_min + full.bounds_max) * 0.5f, world);
+    float radius = 0.5f * VectorLength(full.bounds_max - full.bounds_min) * scale;
+    float distance = VectorLength(center - cam_) - radius;
+    if (distance <= near_clip_) {
+        return 0;
+    }
+
+    size_t level = 0;
+    for (size_t i = 1; i < lod.LevelCount(); ++i) {
+        if (lod.errors[i] * scale * pixels_per_unit_ / distance > lod_threshold_) {
+            break;
+        }
+        level = i;
+    }
+    return level;
+}
+
+void Pipeline::DrawMesh(const MeshLod& lod, const Mat4x4& world, ShadeFunc shade, std::vector<Triangle>& out) {
+    if (lod.LevelCount() > 0) {
+        DrawOne(lod.levels[SelectLod(lod, world)], world, shade, out, { &lod, draw_count_[&lod]++, 0 });
+    }
+}
+
+void Pipeline::DrawMesh(const Mesh& mesh, const Mat4x4& world, ShadeFunc shade, std::vector<Triangle>& out) {
+    DrawOne(mesh, world, shade, out, { &mesh, draw_count_[&mesh]++, 0 });
+}
+
+void Pipeline::DrawOne(const Mesh& mesh, const Mat4x4& world, ShadeFunc shade, std::vector<Triangle>& out, const HistoryKey& key) {
+    if (!temporal_) {
+        DrawPass(mesh, world, shade, out, CullPass::Single, nullptr);
+        return;
+    }
+
+    // Phase one: what was seen last time, phase two runs in ResolveOcclusion
+    std::vector<uint8_t>* history = &History(key, &mesh, mesh.meshlets.Size());
+    size_t out_begin = out.size();
+    DrawPass(mesh, world, shade, out, CullPass::First, history);
+    deferred_.push_back({ &mesh, nullptr, world, shade, &out, out_begin, out.size(), history });
+}
+
+void Pipeline::DrawMesh(const QuantizedMesh& mesh, const Mat4x4& world, ShadeFunc shade, std::vector<Triangle>& out) {
+    if (!temporal_) {
+        DrawPass(mesh, world, shade, out, CullPass::Single, nullptr);
+        return;
+    }
+
+    std::vector<uint8_t>* history = &History({ &mesh, draw_count_[&mesh]++, 0 }, &mesh, mesh.meshlets.size());
+    size_t out_begin = out.size();
+    DrawPass(mesh, world, shade, out, CullPass::First, history);
+    deferred_.push_back({ nullptr, &mesh, world, shade, &out, out_begin, out.size(), history });
+}
+
+void Pipeline::DrawInstanced(const Mesh& mesh, Span<const Mat4x4> worlds, ShadeFunc shade, std::vector<Triangle>& out) {
+    // Each instance keeps its visibility under its index in worlds, whichever of them are culled around it
+    uint32_t draw = draw_count_[&mesh]++;
+    CullInstances(mesh.bounds_min, mesh.bounds_max, worlds);
+    for (uint32_t i : visible_instances_) {
+        DrawOne(mesh, worlds[i], shade, out, { &mesh, draw, i });
+    }
+}
+
+void Pipeline::DrawInstanced(const MeshLod& lod, Span<const Mat4x4> worlds, ShadeFunc shade, std::vector<Triangle>& out) {
+    if (lod.LevelCount() == 0) {
+        return;
+    }
+    uint32_t draw = draw_count_[&lod]++;
+    CullInstances(lod.levels[0].bounds_min, lod.levels[0].bounds_max, worlds);
+    for (uint32_t i : visible_instances_) {
+        DrawOne(lod.levels[SelectLod(lod, worlds[i])], worlds[i], shade, out, { &lod, draw, i });
+    }
+}
+
+void Pipeline::CullInstances(const Vector3d& bounds_min, const Vector3d& bounds_max, Span<const Mat4x4> worlds) {
+    // The center of the sphere around the box moves with each instance, the batch is tested with one radius,
+    // that of the most scaled instance, so a smaller one may be kept but never a visible one dropped
+    Vector3d center = (bounds_min + bounds_max) * 0.5f;
+    float scale = 0.0f;
+    size_t count = worlds.Size();
+    instance_x_.resize(count);
+    instance_y_.resize(count);
+    instance_z_.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        const float(*m)[4] = worlds[i].m;
+        instance_x_[i] = center.x * m[0][0] + center.y * m[1][0] + center.z * m[2][0] + m[3][0];
+        instance_y_[i] = center.x * m[0][1] + center.y * m[1][1] + center.z * m[2][1] + m[3][1];
+        instance_z_[i] = center.x * m[0][2] + center.y * m[1][2] + center.z * m[2][2] + m[3][2];
+        scale = std::max(scale, MaxScale(worlds[i]));
+    }
+    float radius = 0.5f * VectorLength(bounds_max - bounds_min) * scale;
+
+    visible_instances_.resize(count);
+    size_t visible = CullSpheresSoA(instance_x_.data(), instance_y_.data(), instance_z_.data(), radius, count,
+                                    ViewFrustum(), visible_instances_.data());
+    visible_instances_.resize(visible);
+}
+
+void Pipeline::ResolveOcclusion() {
+    if (!temporal_) {
+        return;
+    }
+
+    // The depth of everything phase one drew is the occluder for the rest
+    pyramid_.Clear(screen_width_, screen_height_);
+    for (const DeferredDraw& d : deferred_) {
+        for (size_t i = d.out_begin; i < d.out_end; ++i) {
+            pyramid_.AddOccluder((*d.out)[i]);
+        }
+    }
+    pyramid_.Build();
+
+    const DepthPyramid* external = occlusion_;
+    occlusion_ = &pyramid_;
+    for (const DeferredDraw& d : deferred_) {
+        if (d.mesh) {
+            DrawPass(*d.mesh, d.world, d.shade, *d.out, CullPass::Second, d.history);
+        }
+        else {
+            DrawPass(*d.quantized, d.world, d.shade, *d.out, CullPass::Second, d.history);
+        }
+    }
+    occlusion_ = external;
+    deferred_.clear();
+
+    // Forget meshes that were not drawn this frame, a reloaded or unloaded mesh leaves its entry behind
+    for (auto it = history_.begin(); it != history_.end();) {
+        if (it->second.frame != frame_) {
+            it = history_.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+std::vector<uint8_t>& Pipeline::History(const HistoryKey& key, const void* mesh, size_t meshlet_count) {
+    // One flag per meshlet, or one for the whole mesh. A new mesh starts with nothing seen, so all of it is tested,
+    // and so does a draw that changed its level of detail since, the flags were for other meshlets
+    HistoryEntry& entry = history_[key];
+    size_t count = std::max<size_t>(1, meshlet_count);
+    if (entry.mesh != mesh || entry.visible.size() != count) {
+        entry.visible.assign(count, 0);
+        entry.mesh = mesh;
+    }
+    entry.frame = frame_;
+    return entry.visible;
+}
+
+void Pipeline::DrawPass(const Mesh& mesh, const Mat4x4& world, ShadeFunc shade, std::vector<Triangle>& out,
+                        CullPass pass, std::vector<uint8_t>* history) {
+    // Bring the camera and the light into object space once, instead of every triangle into world space.
+    // The signs of dot products (and with them culling) are the same in both spaces, the light is made unit length
+    // again in object space so a uniform scale in the world matrix leaves the lighting as it is
+    Mat4x4 inv_world = Inverse(world);
+    Vector3d cam_obj = MultiplyMatrixVector(cam_, inv_world);
+    Vector3d light_obj = NormalizeToNew(RotateVector(light_dir_, inv_world));
+    CullMeshlets(mesh.meshlets, mesh.meshlet_bvh, mesh.TriangleCount(), mesh.bounds_min, mesh.bounds_max, world, cam_obj,
+                 pass, history);
+    if (ranges_.empty()) {
+        return;
+    }
+
+    /**
+     * We want to make sure the normal is facing the camera direction, so we introduce a dot product here.
+     * And we can take any points on the triangle as they are all on the same plane.
+     */
+    const VertexStreamView& pos = mesh.positions;
+    const VertexStreamView& nrm = mesh.normals;
+    visible_.clear();
+    visible_light_.clear();
+    visible_clip_.clear();
+    for (const TriangleRange& range : ranges_) {
+        for (uint32_t t = range.begin; t < range.end; ++t) {
+            uint32_t p0 = mesh.indices[t * 3];
+            float facing = nrm.x[t] * (pos.x[p0] - cam_obj.x)
+                         + nrm.y[t] * (pos.y[p0] - cam_obj.y)
+                         + nrm.z[t] * (pos.z[p0] - cam_obj.z);
+            if (facing < 0.0f) {
+                // How "aligned" are light direction and triangle surface normal?
+                visible_.push_back(t);
+                visible_light_.push_back(std::max(0.1f, DotProduct(light_obj, nrm.Get(t))));
+                visible_clip_.push_back(range.clip);
+            }
+        }
+    }
+
+    AssignSlots(mesh.indices, pos.Size());
+    used_positions_.Resize(used_vertices_.size());
+    for (size_t i = 0; i < used_vertices_.size(); ++i) {
+        uint32_t src = used_vertices_[i];
+        used_positions_.x[i] = pos.x[src];
+        used_positions_.y[i] = pos.y[src];
+        used_positions_.z[i] = pos.z[src];
+    }
+
+    // One matrix from object space to screen space, then every used vertex in one batch
+    Mat4x4 mat_full = world * view_projection_viewport_;
+    TransformPointsSoA(used_positions_, screen_positions_, mat_full);
+    EmitTriangles(shade, out);
+}
+
+void Pipeline::DrawPass(const QuantizedMesh& mesh, const Mat4x4& world, ShadeFunc shade, std::vector<Triangle>& out,
+                        CullPass pass, std::vector<uint8_t>* history) {
+    // Same stages as the float mesh, positions and normals are decoded only where they are read
+    Mat4x4 inv_world = Inverse(world);
+    Vector3d cam_obj = MultiplyMatrixVector(cam_, inv_world);
+    Vector3d light_obj = NormalizeToNew(RotateVector(light_dir_, inv_world));
+    CullMeshlets(mesh.meshlets, mesh.meshlet_bvh, mesh.TriangleCount(), mesh.bounds_min, mesh.bounds_max, world, cam_obj,
+                 pass, history);
+    if (ranges_.empty()) {
+        return;
+    }
+
+    visible_.clear();
+    visible_light_.clear();
+    visible_clip_.clear();
+    for (const TriangleRange& range : ranges_) {
+        for (uint32_t t = range.begin; t < range.end; ++t) {
+            Vector3d normal = OctDecodeNormal(mesh.normals[t]);
+            if (DotProduct(normal, mesh.Position(mesh.indices[t * 3]) - cam_obj) < 0.0f) {
+                visible_.push_back(t);
+                visible_light_.push_back(std::max(0.1f, DotProduct(light_obj, normal)));
+                visible_clip_.push_back(range.clip);
+            }
+        }
+    }
+
+    AssignSlots(mesh.indices, mesh.positions.Size());
+    used_quantized_.Resize(used_vertices_.size());
+    for (size_t i = 0; i < used_vertices_.size(); ++i) {
+        uint32_t src = used_vertices_[i];
+        used_quantized_.x[i] = mesh.positions.x[src];
+        used_quantized_.y[i] = mesh.positions.y[src];
+        used_quantized_.z[i] = mesh.positions.z[src];
+    }
+
+    // The dequantization goes in front of the usual matrix, the kernel reads the integers directly
+    Mat4x4 mat_full = mesh.Dequantization() * world * view_projection_viewport_;
+    TransformQuantizedPointsSoA(used_quantized_, screen_positions_, mat_full);
+    EmitTriangles(shade, out);
+}
+
+void Pipeline::CullMeshlets(Span<const Meshlet> meshlets, Span<const BvhNode> bvh, size_t tri_count,
+                            const Vector3d& bounds_min, const Vector3d& bounds_max, const Mat4x4& world, const Vector3d& cam_obj,
+                            CullPass pass, std::vector<uint8_t>* history) {
+    ranges_.clear();
+    Frustum frustum(world * view_projection_, near_clip_);
+    FrustumTest mesh_test = frustum.TestBox(bounds_min, bounds_max);
+    if (mesh_test == FrustumTest::Outside) {
+        return;
+    }
+
+    // Phase one draws what was seen last time without testing it, phase two tests everything else against
+    // the depth phase one left and remembers the outcome for the next frame
+    bool occlusion = pass != CullPass::First && occlusion_ && occlusion_->Ready();
+    Mat4x4 to_screen = world * view_projection_viewport_;
+    auto accept = [&](uint32_t item, const float lo[3], const float hi[3], bool tested) {
+        if (pass == CullPass::First) {
+            return (*history)[item] != 0;
+        }
+        bool hidden = !tested && occlusion && BoxOccluded(lo, hi, to_screen);
+        if (pass == CullPass::Single) {
+            return !hidden;
+        }
+        bool drawn = (*history)[item] != 0;
+        (*history)[item] = !hidden;
+        return !hidden && !drawn;
+    };
+
+    // The whole object against the occluders, then each part of it that is still in question
+    const float mesh_lo[3] = { bounds_min.x, bounds_min.y, bounds_min.z };
+    const float mesh_hi[3] = { bounds_max.x, bounds_max.y, bounds_max.z };
+    if (meshlets.Empty()) {
+        if (accept(0, mesh_lo, mesh_hi, false)) {
+            ranges_.push_back({ 0, (uint32_t)tri_count, mesh_test == FrustumTest::Intersecting });
+        }
+        return;
+    }
+    if (occlusion && BoxOccluded(mesh_lo, mesh_hi, to_screen)) {
+        if (history) {
+            std::fill(history->begin(), history->end(), (uint8_t)0);
+        }
+        return;
+    }
+
+    // Whole meshlets first: off screen, hidden, or every triangle in them facing away, then their triangles one by one.
+    // A meshlet is tested on the box around its sphere, unless the hierarchy node it came in was just that meshlet
+    auto add = [&](uint32_t i, bool clip, bool tested) {
+        const Meshlet& m = meshlets[i];
+        if (MeshletBackfacing(m, cam_obj.x, cam_obj.y, cam_obj.z)) {
+            return;
+        }
+        const float lo[3] = { m.center[0] - m.radius, m.center[1] - m.radius, m.center[2] - m.radius };
+        const float hi[3] = { m.center[0] + m.radius, m.center[1] + m.radius, m.center[2] + m.radius };
+        if (!accept(i, lo, hi, tested)) {
+            return;
+        }
+        uint32_t end = m.triangle_begin + m.triangle_count;
+        if (!ranges_.empty() && ranges_.back().end == m.triangle_begin && ranges_.back().clip == clip) {
+            ranges_.back().end = end;
+        }
+        else {
+            ranges_.push_back({ m.triangle_begin, end, clip });
+        }
+    };
+
+    if (bvh.Empty()) {
+        for (uint32_t i = 0; i < (uint32_t)meshlets.Size(); ++i) {
+            const Meshlet& m = meshlets[i];
+            FrustumTest test = frustum.TestSphere(m.center[0], m.center[1], m.center[2], m.radius);
+            if (test != FrustumTest::Outside) {
+                add(i, test == FrustumTest::Intersecting, false);
+            }
+        }
+        return;
+    }
+
+    // The meshlets are stored in leaf order, so a subtree is a run of them and, with them, a run of triangles.
+    // Subtrees entirely inside need neither the frustum test per meshlet nor the near clip per triangle,
+    // hidden subtrees are dropped on their box
+    auto hidden = [&](const BvhNode& node) {
+        if (!occlusion || !BoxOccluded(node.bounds_min, node.bounds_max, to_screen)) {
+            return false;
+        }
+        if (history) {
+            std::fill(history->begin() + node.first, history->begin() + node.first + node.count, (uint8_t)0);
+        }
+        return true;
+    };
+    CullBvh(bvh, frustum, hidden, [&](uint32_t first, uint32_t count, FrustumTest test) {
+        // A single meshlet was tested on its own box already
+        bool tested = count == 1 && occlusion;
+        for (uint32_t i = first; i < first + count; ++i) {
+            add(i, test == FrustumTest::Intersecting, tested);
+        }
+    });
+}
+
+bool Pipeline::BoxOccluded(const float min[3], const float max[3], const Mat4x4& to_screen) const {
+    // Project the eight corners, a box reaching past the near plane has no screen rectangle and counts as seen
+    const float(*m)[4] = to_screen.m;
+    float min_x = DepthPyramid::FAR_DEPTH, min_y = DepthPyramid::FAR_DEPTH, min_z = DepthPyramid::FAR_DEPTH;
+    float max_x = -DepthPyramid::FAR_DEPTH, max_y = -DepthPyramid::FAR_DEPTH;
+    for (int corner = 0; corner < 8; ++corner) {
+        float x = (corner & 1) ? max[0] : min[0];
+        float y = (corner & 2) ? max[1] : min[1];
+        float z = (corner & 4) ? max[2] : min[2];
+        float w = x * m[0][3] + y * m[1][3] + z * m[2][3] + m[3][3];
+        if (w < near_clip_) {
+            return false;
+        }
+        float inv_w = 1.0f / w;
+        float sx = (x * m[0][0] + y * m[1][0] + z * m[2][0] + m[3][0]) * inv_w;
+        float sy = (x * m[0][1] + y * m[1][1] + z * m[2][1] + m[3][1]) * inv_w;
+        float sz = (x * m[0][2] + y * m[1][2] + z * m[2][2] + m[3][2]) * inv_w;
+        min_x = std::min(min_x, sx);
+        max_x = std::max(max_x, sx);
+        min_y = std::min(min_y, sy);
+        max_y = std::max(max_y, sy);
+        min_z = std::min(min_z, sz);
+    }
+    return occlusion_->Occluded(min_x, min_y, max_x, max_y, min_z);
+}
+
+bool Pipeline::Occluded(const Vector3d& bounds_min, const Vector3d& bounds_max) const {
+    if (!occlusion_ || !occlusion_->Ready()) {
+        return false;
+    }
+    const float lo[3] = { bounds_min.x, bounds_min.y, bounds_min.z };
+    const float hi[3] = { bounds_max.x, bounds_max.y, bounds_max.z };
+    return BoxOccluded(lo, hi, view_projection_viewport_);
+}
+
+void Pipeline::AssignSlots(Span<const uint32_t> indices, size_t vertex_count) {
+    // Give every vertex the survivors use one slot in the post-transform buffer, in first use order
+    vertex_slot_.assign(vertex_count, NO_SLOT);
+    visible_indices_.resize(visible_.size() * 3);
+    used_vertices_.clear();
+    for (size_t v = 0; v < visible_.size(); ++v) {
+        for (size_t i = 0; i < 3; ++i) {
+            uint32_t src = indices[visible_[v] * 3 + i];
+            if (vertex_slot_[src] == NO_SLOT) {
+                vertex_slot_[src] = (uint32_t)used_vertices_.size();
+                used_vertices_.push_back(src);
+            }
+            visible_indices_[v * 3 + i] = vertex_slot_[src];
+        }
+    }
+}
+
+void Pipeline::EmitTriangles(ShadeFunc shade, std::vector<Triangle>& out) {
+    for (size_t v = 0; v < visible_.size(); ++v) {
+        Triangle triangle_clip{};
+        shade(visible_light_[v], triangle_clip);
+        for (int i = 0; i < 3; ++i) {
+            triangle_clip.pts[i] = screen_positions_.Get(visible_indices_[v * 3 + i]);
+        }
+
+        // Clip against the near plane while we still have w, unless the culling found it entirely in front
+        Triangle clipped[2];
+        int clipped_cnt = 1;
+        if (visible_clip_[v]) {
+            clipped_cnt = ClipAgainstNearW(near_clip_, triangle_clip, clipped[0], clipped[1]);
+        }
+        else {
+            clipped[0] = triangle_clip;
+        }
+
+        for (int n = 0; n < clipped_cnt; ++n) {
+            // Perspective divide, the viewport mapping is already part of the vertex matrix
+            for (int i = 0; i < 3; ++i) {
+                clipped[n].pts[i] = VectorDiv(clipped[n].pts[i], clipped[n].pts[i].w);
+            }
+            out.push_back(clipped[n]);
+        }
+    }
+}
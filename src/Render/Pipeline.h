@@ -0,0 +1,326 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "../Maths/Geometry/Frustum.h"
+#include "../Maths/Matrix/Mat4x4.h"
+#include "../Maths/Matrix/TransformBatch.h"
+#include "../Primitive/Mesh.h"
+#include "../Primitive/MeshLod.h"
+#include "../Primitive/QuantizedMesh.h"
+#include "DepthPyramid.h"
+
+/**
+ * @brief The geometry stage of the renderer: object space meshes in, screen space triangles out.
+ *
+ * View, projection and viewport are combined once per frame, and with the world matrix once per mesh,
+ * so every vertex costs one 4x4 transform and one divide. The near plane is clipped in clip space (on w)
+ * before the divide.
+ *
+ * Back faces are culled before anything is transformed: the camera and the light are moved into the
+ * object space of the mesh once, and tested against the precomputed normals and the first corner of each
+ * triangle. Meshes that have meshlets are culled a cluster at a time before that, against the frustum through
+ * the bounding volume hierarchy over them and against the camera with their normal cone, so most hidden
+ * triangles are never looked at. Everything below a node that is entirely inside the frustum skips the near
+ * clip as well. Meshes without meshlets are culled as a whole with their bounding box. Each vertex used by a
+ * surviving triangle is then transformed once into a post-transform buffer, however many triangles share it,
+ * and the triangles pick their corners out of it by index.
+ *
+ * With a depth pyramid set (see SetOcclusion), the box of the mesh and of every hierarchy node in the frustum
+ * is also projected to the screen and dropped if the occluders hide it, before any of its triangles is read.
+ *
+ * With temporal occlusion on (see SetTemporalOcclusion) no occluders are needed: the pipeline remembers which
+ * meshlets were visible last frame. DrawMesh draws only those (phase one), ResolveOcclusion builds a depth
+ * pyramid from what phase one drew and tests the rest against it (phase two). As the camera moves smoothly,
+ * phase one draws nearly the whole visible set and phase two finds the few meshlets that came into view.
+ *
+ * Quantized meshes go through the same stages, their vertices are transformed straight from the 16-bit
+ * integers by folding the dequantization into the vertex matrix.
+ *
+ * Many copies of one mesh are drawn with DrawInstanced: the instances are culled by bounding sphere in one
+ * SIMD batch (see CullSpheresSoA), and each survivor is transformed straight from the shared vertex data with
+ * its own matrix, so the geometry is never copied.
+ *
+ * Meshes with levels of detail are drawn at the coarsest level whose error, projected to the screen at the
+ * distance of the mesh, stays under a threshold in pixels (one console cell by default).
+ */
+class Pipeline {
+public:
+    /**
+     * @brief Turns the light intensity of a triangle into its symbol and colour, supplied by the console side.
+     */
+    using ShadeFunc = void (*)(float lum, Triangle& tri);
+
+    /**
+     * @brief Set up the per frame state.
+     * @param view The view matrix
+     * @param projection The projection matrix
+     * @param screen_width Screen width in pixels
+     * @param screen_height Screen height in pixels
+     * @param cam_pos Camera position in world space
+     * @param near_clip View space depth of the near clipping plane
+     */
+    void BeginFrame(const Mat4x4& view, const Mat4x4& projection, float screen_width, float screen_height,
+                    const Vector3d& cam_pos, float near_clip);
+
+    /**
+     * @brief Draw what DrawMesh held back this frame, with temporal occlusion on. Call after the last DrawMesh
+     * of the frame, the triangles are appended to the vectors given to DrawMesh.
+     */
+    void ResolveOcclusion();
+
+    /**
+     * @brief Cull, transform, light, clip and project a mesh, appending the visible triangles to out.
+     * @param mesh The mesh
+     * @param world The world matrix of the mesh, scale, then rotation and translation
+     * @param shade The shading callback
+     * @param out Receives screen space triangles, z is the depth after the divide
+     */
+    void DrawMesh(const Mesh& mesh, const Mat4x4& world, ShadeFunc shade, std::vector<Triangle>& out);
+
+    /**
+     * @brief Overloaded version for a compressed mesh, the output is the same up to the quantization error.
+     * @param mesh The mesh
+     * @param world The world matrix of the mesh, scale, then rotation and translation
+     * @param shade The shading callback
+     * @param out Receives screen space triangles, z is the depth after the divide
+     */
+    void DrawMesh(const QuantizedMesh& mesh, const Mat4x4& world, ShadeFunc shade, std::vector<Triangle>& out);
+
+    /**
+     * @brief Overloaded version that draws the level of detail picked by SelectLod.
+     * @param lod The levels of the mesh
+     * @param world The world matrix of the mesh, scale, then rotation and translation
+     * @param shade The shading callback
+     * @param out Receives screen space triangles
+     */
+    void DrawMesh(const MeshLod& lod, const Mat4x4& world, ShadeFunc shade, std::vector<Triangle>& out);
+
+    /**
+     * @brief Draw copies of a mesh, one per world matrix. The instances are culled by the bounding sphere of the
+     * mesh in one SIMD batch, the survivors go through the stages of DrawMesh one after the other and share the
+     * vertex data of the mesh, only the per mesh scratch buffers are reused between them. The sphere is grown to
+     * the most scaled instance. With temporal occlusion, an instance keeps its visibility by its index in worlds.
+     * @param mesh The mesh
+     * @param worlds The world matrices, scale, then rotation and translation
+     * @param shade The shading callback
+     * @param out Receives screen space triangles
+     */
+    void DrawInstanced(const Mesh& mesh, Span<const Mat4x4> worlds, ShadeFunc shade, std::vector<Triangle>& out);
+
+    /**
+     * @brief Overloaded version that picks the level of detail per instance.
+     * @param lod The levels of the mesh
+     * @param worlds The world matrices, scale, then rotation and translation
+     * @param shade The shading callback
+     * @param out Receives screen space triangles
+     */
+    void DrawInstanced(const MeshLod& lod, Span<const Mat4x4> worlds, ShadeFunc shade, std::vector<Triangle>& out);
+
+    /**
+     * @brief Pick the level of detail for this frame from the screen space error of every level.
+     * @param lod The levels of the mesh
+     * @param world The world matrix of the mesh, scale, then rotation and translation
+     * @return Index of the coarsest level that is within the threshold
+     */
+    size_t SelectLod(const MeshLod& lod, const Mat4x4& world) const;
+
+    /**
+     * @brief The frustum of the current frame, to cull objects by their world space bounds before drawing them.
+     * @return The frustum in world space, with the near plane of the pipeline
+     */
+    Frustum ViewFrustum() const;
+
+    /**
+     * @brief Test a world space box against the occluders, for objects drawn without DrawMesh.
+     * @param bounds_min The box
+     * @param bounds_max
+     * @return true if the depth pyramid hides it, false without one
+     */
+    bool Occluded(const Vector3d& bounds_min, const Vector3d& bounds_max) const;
+
+    /**
+     * @brief Cull against the occluders in a depth pyramid from now on, built by the caller for this frame.
+     * @param pyramid The pyramid, in screen space of the current frame, nullptr to turn occlusion culling off
+     */
+    void SetOcclusion(const DepthPyramid* pyramid) { occlusion_ = pyramid; }
+
+    /**
+     * @brief Reuse the visibility of the last frame, see the class description. Meshes passed to DrawMesh must
+     * stay alive until ResolveOcclusion, which has to be called every frame while this is on.
+     * @param enabled true to turn it on, the first frame after draws everything in phase two
+     */
+    void SetTemporalOcclusion(bool enabled) {
+        temporal_ = enabled;
+        history_.clear();
+    }
+
+    /**
+     * @brief How much a level may differ from the full mesh on screen.
+     * @param pixels The threshold in pixels (console cells)
+     */
+    void SetLodThreshold(float pixels) { lod_threshold_ = pixels; }
+
+private:
+    /**
+     * @brief Which meshlets a culling pass hands on: all that pass the tests (occlusion off, or an external
+     * pyramid), the ones visible last frame (phase one), or the ones that are visible now and were not drawn yet (phase two).
+     */
+    enum class CullPass {
+        Single,
+        First,
+        Second
+    };
+
+    /**
+     * @brief A DrawMesh call of phase one, redone in phase two.
+     */
+    struct DeferredDraw {
+        const Mesh* mesh;                   // One of the two is set
+        const QuantizedMesh* quantized;
+        Mat4x4 world;
+        ShadeFunc shade;
+        std::vector<Triangle>* out;
+        size_t out_begin, out_end;          // The triangles phase one added to out
+        std::vector<uint8_t>* history;
+    };
+
+    /**
+     * @brief What was drawn (a mesh or the levels of one), which of its draw calls this frame and which instance
+     * of that call, so every instance has visibility of its own, matched up with the same one next frame.
+     */
+    struct HistoryKey {
+        const void* source;
+        uint32_t draw;
+        uint32_t instance;      // Index into the world matrices of DrawInstanced, 0 for DrawMesh
+        bool operator==(const HistoryKey& o) const { return source == o.source && draw == o.draw && instance == o.instance; }
+    };
+
+    struct HistoryKeyHash {
+        size_t operator()(const HistoryKey& k) const {
+            uint64_t h = (uint64_t)(uintptr_t)k.source * 0x9E3779B97F4A7C15ull;
+            h ^= (h >> 29) + (((uint64_t)k.draw << 32) | k.instance) * 0xBF58476D1CE4E5B9ull;
+            return (size_t)(h ^ (h >> 32));
+        }
+    };
+
+    /**
+     * @brief Visibility of one mesh at the last frame it was drawn.
+     */
+    struct HistoryEntry {
+        std::vector<uint8_t> visible;       // Per meshlet, or one flag for a mesh without meshlets
+        const void* mesh = nullptr;         // The mesh the flags are for, the level of detail drawn
+        uint64_t frame = 0;                 // Frame it was last drawn, older entries are dropped
+    };
+
+    /**
+     * @brief A run of triangles that survived the meshlet tests, [begin, end).
+     */
+    struct TriangleRange {
+        uint32_t begin, end;
+        bool clip;      // false when the run is entirely in front of the near plane
+    };
+
+    /**
+     * @brief Fill ranges_ with the triangles of the meshlets that may be visible, all triangles if there are none
+     * and the mesh is not off screen as a whole.
+     * @param meshlets The meshlets of the mesh
+     * @param bvh The hierarchy over the meshlets, the sphere of every meshlet is tested if it is empty
+     * @param tri_count Triangle count of the mesh
+     * @param bounds_min Object space bounding box of the mesh
+     * @param bounds_max
+     * @param world The world matrix of the mesh
+     * @param cam_obj Camera position in object space
+     * @param pass The pass
+     * @param history Visibility of the meshlets, read in phase one and updated in phase two, nullptr for a single pass
+     */
+    void CullMeshlets(Span<const Meshlet> meshlets, Span<const BvhNode> bvh, size_t tri_count,
+                      const Vector3d& bounds_min, const Vector3d& bounds_max, const Mat4x4& world, const Vector3d& cam_obj,
+                      CullPass pass, std::vector<uint8_t>* history);
+
+    /**
+     * @brief Draw a mesh in one or two passes, with the visibility of last time kept under key.
+     */
+    void DrawOne(const Mesh& mesh, const Mat4x4& world, ShadeFunc shade, std::vector<Triangle>& out, const HistoryKey& key);
+
+    /**
+     * @brief The stages of DrawMesh for one pass.
+     */
+    void DrawPass(const Mesh& mesh, const Mat4x4& world, ShadeFunc shade, std::vector<Triangle>& out,
+                  CullPass pass, std::vector<uint8_t>* history);
+    void DrawPass(const QuantizedMesh& mesh, const Mat4x4& world, ShadeFunc shade, std::vector<Triangle>& out,
+                  CullPass pass, std::vector<uint8_t>* history);
+
+    /**
+     * @brief Sphere cull the instances of a mesh into visible_instances_.
+     * @param bounds_min Object space bounding box of the mesh
+     * @param bounds_max
+     * @param worlds The world matrices
+     */
+    void CullInstances(const Vector3d& bounds_min, const Vector3d& bounds_max, Span<const Mat4x4> worlds);
+
+    /**
+     * @brief The visibility flags of a draw, sized for the meshlets of the mesh drawn and marked as used.
+     * @param key The draw
+     * @param mesh The mesh drawn, the flags start over when it is not the one of last time
+     * @param meshlet_count Meshlet count of the mesh
+     * @return One flag per meshlet, or one for a mesh without meshlets
+     */
+    std::vector<uint8_t>& History(const HistoryKey& key, const void* mesh, size_t meshlet_count);
+
+    /**
+     * @brief Project a box to the screen and test it against the depth pyramid.
+     * @param min The box
+     * @param max
+     * @param to_screen The matrix from the space of the box to the screen (before the divide)
+     * @return true if it is hidden, false if it reaches past the near plane
+     */
+    bool BoxOccluded(const float min[3], const float max[3], const Mat4x4& to_screen) const;
+
+    /**
+     * @brief Fill visible_indices_ and used_vertices_ from visible_, one post-transform slot per vertex used.
+     * @param indices Index buffer of the mesh
+     * @param vertex_count Vertex count of the mesh
+     */
+    void AssignSlots(Span<const uint32_t> indices, size_t vertex_count);
+
+    /**
+     * @brief Shade, clip and divide the visible triangles once screen_positions_ is filled.
+     * @param shade The shading callback
+     * @param out Receives screen space triangles
+     */
+    void EmitTriangles(ShadeFunc shade, std::vector<Triangle>& out);
+
+    Mat4x4 view_projection_;                // view * projection for the current frame, the frustum comes from it
+    Mat4x4 view_projection_viewport_;       // view * projection * viewport for the current frame
+    Vector3d cam_;                          // Camera position in world space
+    Vector3d light_dir_{ 0.0f, 1.0f, -1.0f };
+    float near_clip_ = 0.1f;
+    float pixels_per_unit_ = 1.0f;          // Screen size of one world unit at distance 1
+    float lod_threshold_ = 1.0f;            // Largest screen space error of a level, in pixels
+    const DepthPyramid* occlusion_ = nullptr;   // Occluders of the frame, not owned
+    bool temporal_ = false;                 // Two phase occlusion culling on
+    int screen_width_ = 0;
+    int screen_height_ = 0;
+    uint64_t frame_ = 0;                    // Counts BeginFrame calls
+    std::unordered_map<HistoryKey, HistoryEntry, HistoryKeyHash> history_;     // Draw of a mesh -> its visibility
+    std::unordered_map<const void*, uint32_t> draw_count_;     // Mesh or levels -> draw calls this frame
+    std::vector<DeferredDraw> deferred_;    // Phase one draws of the current frame
+    DepthPyramid pyramid_;                  // Depth of phase one
+    std::vector<TriangleRange> ranges_;     // Per mesh triangles left after the meshlet tests
+    std::vector<float> instance_x_;         // World space centers of the instances being drawn
+    std::vector<float> instance_y_;
+    std::vector<float> instance_z_;
+    std::vector<uint32_t> visible_instances_;   // The ones in the frustum
+    std::vector<uint32_t> visible_;         // Per mesh indices of the triangles facing the camera
+    std::vector<float> visible_light_;      // Light intensity of each of them
+    std::vector<uint8_t> visible_clip_;     // Whether each of them may cross the near plane
+    std::vector<uint32_t> vertex_slot_;     // Mesh vertex -> its slot in the post-transform buffer, or NO_SLOT
+    std::vector<uint32_t> visible_indices_; // Corners of the visible triangles as post-transform slots
+    std::vector<uint32_t> used_vertices_;   // Slot -> mesh vertex
+    VertexStreamSoA used_positions_;        // The vertices referenced by visible triangles, once each
+    QuantizedStreamSoA used_quantized_;     // The same for a quantized mesh
+    HomogeneousStreamSoA screen_positions_; // Post-transform buffer, used_positions_ transformed
+
+    static constexpr uint32_t NO_SLOT = 0xFFFFFFFFu;
+};
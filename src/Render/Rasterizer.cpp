@@ -0,0 +1,315 @@
+#include <algorithm>
+#include "Rasterizer.h"
+#include "../Maths/Vector/Vec4.h"
+#include "../Platform/CpuFeatures.h"
+
+#if defined(RASTERIZER_X86)
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+
+/**
+ * @brief One edge function E(p) = (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x), stepped per pixel.
+ */
+struct Edge {
+    int64_t step_x;     // Change of E for one pixel to the right
+    int64_t step_y;     // Change of E for one row down
+    int64_t row;        // E (with the fill rule bias) at the first pixel center of the current row
+
+    Edge() = default;
+
+    Edge(Fixed28_4 ax, Fixed28_4 ay, Fixed28_4 bx, Fixed28_4 by, Fixed28_4 px, Fixed28_4 py) {
+        int64_t dx = (int64_t)bx - ax;
+        int64_t dy = (int64_t)by - ay;
+        step_x = -dy * SUBPIXEL_ONE;
+        step_y = dx * SUBPIXEL_ONE;
+        row = dx * ((int64_t)py - ay) - dy * ((int64_t)px - ax);
+
+        // Top-left rule. With the winding used below (y down), a left edge goes up and a top edge is
+        // horizontal going right. Points exactly on any other edge are outside, so E must be > 0 there.
+        bool top_left = dy < 0 || (dy == 0 && dx > 0);
+        if (!top_left) {
+            row -= 1;
+        }
+    }
+};
+
+/**
+ * @brief Everything the row loops need, shared by all kernels.
+ */
+struct TriangleSetup {
+    Edge edges[3];
+    int px_begin, px_last;  // Covered columns are within [px_begin, px_last]
+    int py_begin, py_last;  // Covered rows are within [py_begin, py_last]
+    bool fits_int32;        // Edge values stay within 32 bits, so the SIMD kernels may run
+};
+
+/**
+ * @brief Sort out winding, bounding box and the three edges.
+ * @return false if the triangle covers nothing
+ */
+bool SetupTriangle(const Fixed28_4 x[3], const Fixed28_4 y[3], int clip_width, int clip_height, TriangleSetup& s) {
+    // Bring the triangle to a positive signed area, degenerate triangles cover nothing
+    int64_t area = ((int64_t)x[1] - x[0]) * ((int64_t)y[2] - y[0]) - ((int64_t)y[1] - y[0]) * ((int64_t)x[2] - x[0]);
+    if (area == 0) {
+        return false;
+    }
+    int i1 = area > 0 ? 1 : 2;
+    int i2 = area > 0 ? 2 : 1;
+
+    // Pixel px has its center at px * 16 + 8, take the pixels whose centers fall in the bounding box
+    const Fixed28_4 half = SUBPIXEL_ONE / 2;
+    Fixed28_4 min_x = std::min({ x[0], x[1], x[2] });
+    Fixed28_4 max_x = std::max({ x[0], x[1], x[2] });
+    Fixed28_4 min_y = std::min({ y[0], y[1], y[2] });
+    Fixed28_4 max_y = std::max({ y[0], y[1], y[2] });
+    s.px_begin = std::max(0, (min_x - half + SUBPIXEL_ONE - 1) >> SUBPIXEL_BITS);
+    s.px_last = std::min(clip_width - 1, (max_x - half) >> SUBPIXEL_BITS);
+    s.py_begin = std::max(0, (min_y - half + SUBPIXEL_ONE - 1) >> SUBPIXEL_BITS);
+    s.py_last = std::min(clip_height - 1, (max_y - half) >> SUBPIXEL_BITS);
+    if (s.px_begin > s.px_last || s.py_begin > s.py_last) {
+        return false;
+    }
+
+    // |E| <= 2 * width * height over the box, plus up to 15 pixels of SIMD overshoot past the right side
+    const int64_t limit = (int64_t)1024 << SUBPIXEL_BITS;
+    s.fits_int32 = (int64_t)max_x - min_x < limit && (int64_t)max_y - min_y < limit;
+
+    Fixed28_4 cx = (s.px_begin << SUBPIXEL_BITS) + half;
+    Fixed28_4 cy = (s.py_begin << SUBPIXEL_BITS) + half;
+    s.edges[0] = Edge(x[0], y[0], x[i1], y[i1], cx, cy);
+    s.edges[1] = Edge(x[i1], y[i1], x[i2], y[i2], cx, cy);
+    s.edges[2] = Edge(x[i2], y[i2], x[0], y[0], cx, cy);
+    return true;
+}
+
+/**
+ * @brief Index of the lowest set bit, mask must not be 0.
+ */
+inline int LowestBit(unsigned mask) {
+#if defined(_MSC_VER)
+    unsigned long i;
+    _BitScanForward(&i, mask);
+    return (int)i;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+/**
+ * @brief Index of the highest set bit, mask must not be 0.
+ */
+inline int HighestBit(unsigned mask) {
+#if defined(_MSC_VER)
+    unsigned long i;
+    _BitScanReverse(&i, mask);
+    return (int)i;
+#else
+    return 31 - __builtin_clz(mask);
+#endif
+}
+
+/**
+ * @brief Turn per block coverage masks into the span of one row. Pixels of a row are one contiguous run,
+ * so the span starts at the first covered lane and ends at the first uncovered lane after it.
+ */
+struct SpanTracker {
+    int begin = -1;
+    int end = -1;
+
+    /**
+     * @param px Column of lane 0
+     * @param inside Covered lanes
+     * @param lanes Number of lanes that are still inside the bounding box
+     * @return true once the span is complete
+     */
+    bool Feed(int px, unsigned inside, int lanes) {
+        if (inside == 0) {
+            if (begin >= 0) {
+                end = px;
+                return true;
+            }
+            return false;
+        }
+        if (begin < 0) {
+            begin = px + LowestBit(inside);
+        }
+        int hi = HighestBit(inside);
+        if (hi < lanes - 1) {
+            end = px + hi + 1;
+            return true;
+        }
+        return false;
+    }
+};
+
+/**
+ * @brief Reference kernel, one pixel at a time on 64-bit edge values.
+ */
+void FillRowsScalar(TriangleSetup& s, SpanFunc emit, void* user) {
+    Edge& e0 = s.edges[0];
+    Edge& e1 = s.edges[1];
+    Edge& e2 = s.edges[2];
+
+    for (int py = s.py_begin; py <= s.py_last; ++py) {
+        int64_t w0 = e0.row, w1 = e1.row, w2 = e2.row;
+        int span_begin = -1;
+        int px = s.px_begin;
+
+        // The triangle is convex, so the covered pixels of a row are one contiguous run
+        for (; px <= s.px_last; ++px) {
+            bool inside = (w0 | w1 | w2) >= 0;
+            if (inside && span_begin < 0) {
+                span_begin = px;
+            }
+            else if (!inside && span_begin >= 0) {
+                break;
+            }
+            w0 += e0.step_x;
+            w1 += e1.step_x;
+            w2 += e2.step_x;
+        }
+
+        if (span_begin >= 0) {
+            emit(user, { py, span_begin, px });
+        }
+
+        e0.row += e0.step_y;
+        e1.row += e1.step_y;
+        e2.row += e2.step_y;
+    }
+}
+
+#if defined(RASTERIZER_VEC4_SSE)
+
+/**
+ * @brief 4 pixels at a time on 32-bit edge values with SSE2.
+ */
+void FillRowsSse2(TriangleSetup& s, SpanFunc emit, void* user) {
+    __m128i lane_offset[3], block_step[3];
+    for (int k = 0; k < 3; ++k) {
+        int32_t sx = (int32_t)s.edges[k].step_x;
+        lane_offset[k] = _mm_setr_epi32(0, sx, 2 * sx, 3 * sx);
+        block_step[k] = _mm_set1_epi32(4 * sx);
+    }
+
+    for (int py = s.py_begin; py <= s.py_last; ++py) {
+        __m128i w[3];
+        for (int k = 0; k < 3; ++k) {
+            w[k] = _mm_add_epi32(_mm_set1_epi32((int32_t)s.edges[k].row), lane_offset[k]);
+        }
+
+        SpanTracker span;
+        bool done = false;
+        int px = s.px_begin;
+        for (; px <= s.px_last && !done; px += 4) {
+            // Sign bit set in any edge means outside
+            __m128i any = _mm_or_si128(_mm_or_si128(w[0], w[1]), w[2]);
+            int lanes = std::min(4, s.px_last - px + 1);
+            unsigned inside = ~(unsigned)_mm_movemask_ps(_mm_castsi128_ps(any)) & ((1u << lanes) - 1);
+            done = span.Feed(px, inside, lanes);
+            for (int k = 0; k < 3; ++k) {
+                w[k] = _mm_add_epi32(w[k], block_step[k]);
+            }
+        }
+
+        if (span.begin >= 0) {
+            emit(user, { py, span.begin, done ? span.end : s.px_last + 1 });
+        }
+
+        for (int k = 0; k < 3; ++k) {
+            s.edges[k].row += s.edges[k].step_y;
+        }
+    }
+}
+
+#endif
+
+#if defined(RASTERIZER_X86)
+
+/**
+ * @brief 8 pixels at a time on 32-bit edge values with AVX2.
+ */
+RASTERIZER_TARGET_AVX2
+void FillRowsAvx2(TriangleSetup& s, SpanFunc emit, void* user) {
+    __m256i lane_offset[3], block_step[3];
+    for (int k = 0; k < 3; ++k) {
+        int32_t sx = (int32_t)s.edges[k].step_x;
+        lane_offset[k] = _mm256_setr_epi32(0, sx, 2 * sx, 3 * sx, 4 * sx, 5 * sx, 6 * sx, 7 * sx);
+        block_step[k] = _mm256_set1_epi32(8 * sx);
+    }
+
+    for (int py = s.py_begin; py <= s.py_last; ++py) {
+        __m256i w[3];
+        for (int k = 0; k < 3; ++k) {
+            w[k] = _mm256_add_epi32(_mm256_set1_epi32((int32_t)s.edges[k].row), lane_offset[k]);
+        }
+
+        SpanTracker span;
+        bool done = false;
+        int px = s.px_begin;
+        for (; px <= s.px_last && !done; px += 8) {
+            // Sign bit set in any edge means outside
+            __m256i any = _mm256_or_si256(_mm256_or_si256(w[0], w[1]), w[2]);
+            int lanes = std::min(8, s.px_last - px + 1);
+            unsigned inside = ~(unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(any)) & ((1u << lanes) - 1);
+            done = span.Feed(px, inside, lanes);
+            for (int k = 0; k < 3; ++k) {
+                w[k] = _mm256_add_epi32(w[k], block_step[k]);
+            }
+        }
+
+        if (span.begin >= 0) {
+            emit(user, { py, span.begin, done ? span.end : s.px_last + 1 });
+        }
+
+        for (int k = 0; k < 3; ++k) {
+            s.edges[k].row += s.edges[k].step_y;
+        }
+    }
+}
+
+#endif
+
+using FillRowsFunc = void (*)(TriangleSetup&, SpanFunc, void*);
+
+/**
+ * @brief Pick the kernel for the active CPU tier, done once. AVX-512 hosts use the AVX2 version,
+ * console rows are too short to fill 16 lanes.
+ */
+FillRowsFunc SelectFillRows() {
+    switch (ActiveCpuLevel()) {
+#if defined(RASTERIZER_X86)
+        case CpuLevel::Avx512:
+        case CpuLevel::Avx2:
+            return FillRowsAvx2;
+#endif
+#if defined(RASTERIZER_VEC4_SSE)
+        case CpuLevel::Simd128: return FillRowsSse2;
+#endif
+        default: return FillRowsScalar;
+    }
+}
+
+}
+
+void FillTriangleFixed(const Fixed28_4 x[3], const Fixed28_4 y[3], int clip_width, int clip_height, SpanFunc emit, void* user) {
+    static const FillRowsFunc kernel = SelectFillRows();
+
+    TriangleSetup setup;
+    if (!SetupTriangle(x, y, clip_width, clip_height, setup)) {
+        return;
+    }
+
+    // Huge triangles would overflow the 32-bit lanes, they take the 64-bit path
+    if (setup.fits_int32) {
+        kernel(setup, emit, user);
+    }
+    else {
+        FillRowsScalar(setup, emit, user);
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+
+/**
+ * @brief A screen coordinate in 28.4 fixed point: 28 integer bits, 4 fractional bits (1/16 of a pixel).
+ */
+using Fixed28_4 = int32_t;
+
+constexpr int SUBPIXEL_BITS = 4;                    // Fractional bits of Fixed28_4
+constexpr int SUBPIXEL_ONE = 1 << SUBPIXEL_BITS;    // One pixel in Fixed28_4 units
+
+/**
+ * @brief Convert a float screen coordinate to 28.4, rounding to the nearest sub-pixel.
+ * @param v The coordinate in pixels
+ * @return The coordinate in 1/16 pixels
+ */
+inline Fixed28_4 ToFixed28_4(float v) {
+    return (Fixed28_4)std::lrint(v * (float)SUBPIXEL_ONE);
+}
+
+/**
+ * @brief A run of covered pixels on one row, x_end is exclusive.
+ */
+struct RasterSpan {
+    int y;
+    int x_begin;
+    int x_end;
+};
+
+/**
+ * @brief Receives the spans of a triangle, user is passed through untouched.
+ */
+using SpanFunc = void (*)(void* user, const RasterSpan& span);
+
+/**
+ * @brief Fill a triangle given in 28.4 fixed point, any winding.
+ * A pixel is covered when its center lies inside the triangle. Centers exactly on an edge follow the
+ * top-left rule, so two triangles sharing an edge never both cover a pixel and leave no gap between them.
+ * Setup and stepping are integer only.
+ * @param x The x coordinates of the three corners
+ * @param y The y coordinates of the three corners
+ * @param clip_width Pixels at x >= clip_width are skipped
+ * @param clip_height Rows at y >= clip_height are skipped
+ * @param emit Called once per covered row, top to bottom
+ * @param user Passed to emit
+ */
+void FillTriangleFixed(const Fixed28_4 x[3], const Fixed28_4 y[3], int clip_width, int clip_height, SpanFunc emit, void* user);
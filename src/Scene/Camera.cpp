@@ -0,0 +1,19 @@
+#include "Camera.h"
+
+void Camera::RebuildLookDir() {
+    // MakeRotationY(yaw_) is what the controls were tuned with, it turns opposite to the right handed quaternion
+    Quaternion rotation = QuaternionFromAxisAngle({ 0.0f, 1.0f, 0.0f }, -yaw_);
+    look_dir_ = RotateByQuaternion(rotation, { 0.0f, 0.0f, 1.0f });
+    look_dirty_ = false;
+}
+
+void Camera::RebuildView() {
+    // Helper Up vector
+    Vector3d up = { 0.0f, 1.0f, 0.0f };
+    Vector3d target = position_ + LookDir();
+
+    // Camera matrix, then the view matrix is its inverse
+    Mat4x4 mat_cam = PointAt(position_, target, up);
+    view_ = Inverse(mat_cam);
+    view_dirty_ = false;
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include "../Maths/Quaternion/Quaternion.h"
+
+/**
+ * @brief A first person camera that turns around the world up axis.
+ * The look direction, the view matrix and the projection are cached and only rebuilt after a change,
+ * so a camera standing still does no PointAt/Inverse work at all.
+ */
+class Camera {
+public:
+    /**
+     * @brief Set up the projection.
+     * @param fov_degrees FOV degrees
+     * @param aspect_ratio Ratio between height and width
+     * @param near_plane The near plane of the frustum
+     * @param far_plane The far plane of the frustum
+     */
+    void SetProjection(float fov_degrees, float aspect_ratio, float near_plane, float far_plane) {
+        projection_ = MakeProjection(fov_degrees, aspect_ratio, near_plane, far_plane);
+    }
+
+    /**
+     * @brief Move the camera to a new position.
+     * @param position The position in world space
+     */
+    void SetPosition(const Vector3d& position) {
+        position_ = position;
+        view_dirty_ = true;
+    }
+
+    /**
+     * @brief Move the camera by an offset.
+     * @param offset The offset in world space
+     */
+    void Translate(const Vector3d& offset) {
+        SetPosition(position_ + offset);
+    }
+
+    /**
+     * @brief Turn the camera left or right.
+     * @param delta_rad Angle to add to the yaw, in radius
+     */
+    void AddYaw(float delta_rad) {
+        yaw_ += delta_rad;
+        look_dirty_ = true;
+        view_dirty_ = true;
+    }
+
+    const Vector3d& Position() const { return position_; }
+    float Yaw() const { return yaw_; }
+    const Mat4x4& Projection() const { return projection_; }
+
+    /**
+     * @brief The look direction, unit length.
+     * @return The cached direction, rebuilt first if the yaw changed
+     */
+    const Vector3d& LookDir() {
+        if (look_dirty_) {
+            RebuildLookDir();
+        }
+        return look_dir_;
+    }
+
+    /**
+     * @brief The view matrix, world space to camera space.
+     * @return The cached matrix, rebuilt first if the camera moved or turned
+     */
+    const Mat4x4& View() {
+        if (view_dirty_) {
+            RebuildView();
+        }
+        return view_;
+    }
+
+private:
+    /**
+     * @brief Rotate the forward axis by the yaw, one sincos.
+     */
+    void RebuildLookDir();
+
+    /**
+     * @brief PointAt + Inverse from the current position and look direction.
+     */
+    void RebuildView();
+
+    Vector3d position_;                 // Position in world space
+    Vector3d look_dir_{ 0.0f, 0.0f, 1.0f };
+    float yaw_ = 0.0f;                  // An angle for FPS look direction
+    Mat4x4 view_ = MakeIdentity();      // Cached view matrix
+    Mat4x4 projection_ = MakeIdentity();
+    bool look_dirty_ = false;           // The default look_dir_ already matches a yaw of 0
+    bool view_dirty_ = true;
+};
@@ -0,0 +1,229 @@
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include "HeightmapTerrain.h"
+
+namespace {
+
+// A level starts to morph into the next one this far into the stretch between its two ranges
+constexpr float MORPH_START_RATIO = 0.7f;
+
+/**
+ * @brief Whether a box reaches into a sphere.
+ */
+bool BoxInSphere(const Vector3d& box_min, const Vector3d& box_max, const Vector3d& center, float radius) {
+    float dx = std::max({ box_min.x - center.x, 0.0f, center.x - box_max.x });
+    float dy = std::max({ box_min.y - center.y, 0.0f, center.y - box_max.y });
+    float dz = std::max({ box_min.z - center.z, 0.0f, center.z - box_max.z });
+    return dx * dx + dy * dy + dz * dz <= radius * radius;
+}
+
+}
+
+void HeightmapTerrain::SetHeightmap(Heightmap&& map) {
+    map_ = std::move(map);
+    Build();
+}
+
+bool HeightmapTerrain::Open(const std::string& path, uint32_t width, uint32_t depth, float cell_size, float height_scale) {
+    Heightmap map;
+    if (!LoadHeightmapRaw16(path, width, depth, cell_size, height_scale, map)) {
+        return false;
+    }
+    SetHeightmap(std::move(map));
+    return true;
+}
+
+void HeightmapTerrain::SetLod(uint32_t chunk_cells, float lod_distance) {
+    // Grid coordinates of a chunk must stay even at every level, also for the quarter of a node drawn at the level
+    // above it, so the size is a power of two of at least 4
+    chunk_cells_ = 4;
+    while (chunk_cells_ < chunk_cells) {
+        chunk_cells_ *= 2;
+    }
+    lod_distance_ = lod_distance;
+    Build();
+}
+
+void HeightmapTerrain::Build() {
+    levels_.clear();
+    ranges_.clear();
+    morph_start_.clear();
+    chunks_.clear();
+    if (map_.width < 2 || map_.depth < 2) {
+        return;
+    }
+
+    // Level 0 from the samples, every level above from the four nodes below it, up to a single root
+    const uint32_t cells_x = map_.width - 1, cells_z = map_.depth - 1;
+    LevelBounds leaves;
+    leaves.nodes_x = (cells_x + chunk_cells_ - 1) / chunk_cells_;
+    leaves.nodes_z = (cells_z + chunk_cells_ - 1) / chunk_cells_;
+    leaves.min_height.resize((size_t)leaves.nodes_x * leaves.nodes_z);
+    leaves.max_height.resize(leaves.min_height.size());
+    for (uint32_t nz = 0; nz < leaves.nodes_z; ++nz) {
+        for (uint32_t nx = 0; nx < leaves.nodes_x; ++nx) {
+            float lo = FLT_MAX, hi = -FLT_MAX;
+            uint32_t x_end = std::min((nx + 1) * chunk_cells_, cells_x);
+            uint32_t z_end = std::min((nz + 1) * chunk_cells_, cells_z);
+            for (uint32_t z = nz * chunk_cells_; z <= z_end; ++z) {
+                for (uint32_t x = nx * chunk_cells_; x <= x_end; ++x) {
+                    float h = map_.At(x, z);
+                    lo = std::min(lo, h);
+                    hi = std::max(hi, h);
+                }
+            }
+            leaves.min_height[(size_t)nz * leaves.nodes_x + nx] = lo;
+            leaves.max_height[(size_t)nz * leaves.nodes_x + nx] = hi;
+        }
+    }
+    levels_.push_back(std::move(leaves));
+
+    while (levels_.back().nodes_x > 1 || levels_.back().nodes_z > 1) {
+        const LevelBounds& below = levels_.back();
+        LevelBounds level;
+        level.nodes_x = (below.nodes_x + 1) / 2;
+        level.nodes_z = (below.nodes_z + 1) / 2;
+        level.min_height.assign((size_t)level.nodes_x * level.nodes_z, FLT_MAX);
+        level.max_height.assign(level.min_height.size(), -FLT_MAX);
+        for (uint32_t nz = 0; nz < below.nodes_z; ++nz) {
+            for (uint32_t nx = 0; nx < below.nodes_x; ++nx) {
+                size_t parent = (size_t)(nz / 2) * level.nodes_x + nx / 2;
+                size_t child = (size_t)nz * below.nodes_x + nx;
+                level.min_height[parent] = std::min(level.min_height[parent], below.min_height[child]);
+                level.max_height[parent] = std::max(level.max_height[parent], below.max_height[child]);
+            }
+        }
+        levels_.push_back(std::move(level));
+    }
+
+    // Where two levels meet, the finer chunk must have finished morphing and the coarser one not started.
+    // The finer one is within ranges_[l - 1] plus the diagonal of a level l node of a point that is in range,
+    // so the morph of level l starts no closer than that
+    float lod0 = lod_distance_;
+    for (size_t l = 1; l < levels_.size(); ++l) {
+        float size = (float)(chunk_cells_ << l) * map_.cell_size;
+        float height = 0.0f;
+        for (size_t i = 0; i < levels_[l].min_height.size(); ++i) {
+            height = std::max(height, levels_[l].max_height[i] - levels_[l].min_height[i]);
+        }
+        float diagonal = std::sqrt(2.0f * size * size + height * height);
+        float scale = (float)(1u << (l - 1));
+        lod0 = std::max(lod0, diagonal / (MORPH_START_RATIO * scale) * 1.01f);
+    }
+
+    // Each level reaches twice as far as the one below it, the top one covers everything left
+    for (size_t l = 0; l < levels_.size(); ++l) {
+        float range = l + 1 < levels_.size() ? lod0 * (float)(1u << l) : FLT_MAX;
+        float previous = l > 0 ? ranges_[l - 1] : 0.0f;
+        ranges_.push_back(range);
+        morph_start_.push_back(l + 1 < levels_.size() ? previous + (range - previous) * MORPH_START_RATIO : FLT_MAX);
+    }
+}
+
+bool HeightmapTerrain::NodeBox(uint32_t level, uint32_t node_x, uint32_t node_z, Vector3d& box_min, Vector3d& box_max) const {
+    const LevelBounds& bounds = levels_[level];
+    if (node_x >= bounds.nodes_x || node_z >= bounds.nodes_z) {
+        return false;
+    }
+    uint32_t size = chunk_cells_ << level;
+    size_t i = (size_t)node_z * bounds.nodes_x + node_x;
+    box_min = { (float)(node_x * size) * map_.cell_size, bounds.min_height[i], (float)(node_z * size) * map_.cell_size };
+    box_max = { std::min((float)((node_x + 1) * size) * map_.cell_size, map_.SizeX()), bounds.max_height[i],
+                std::min((float)((node_z + 1) * size) * map_.cell_size, map_.SizeZ()) };
+    return true;
+}
+
+bool HeightmapTerrain::Select(uint32_t level, uint32_t node_x, uint32_t node_z, const Frustum& frustum, const Vector3d& cam_pos) {
+    Vector3d box_min, box_max;
+    if (!NodeBox(level, node_x, node_z, box_min, box_max)) {
+        return true;
+    }
+    if (!BoxInSphere(box_min, box_max, cam_pos, ranges_[level])) {
+        return false;
+    }
+    if (frustum.TestBox(box_min, box_max) == FrustumTest::Outside) {
+        return true;
+    }
+
+    uint32_t size = chunk_cells_ << level;
+    if (level == 0 || !BoxInSphere(box_min, box_max, cam_pos, ranges_[level - 1])) {
+        chunks_.push_back({ node_x * size, node_z * size, size, level });
+        return true;
+    }
+
+    // Children out of the range of their level are drawn at this level instead, a quarter of this node each
+    for (uint32_t c = 0; c < 4; ++c) {
+        uint32_t child_x = node_x * 2 + (c & 1), child_z = node_z * 2 + (c >> 1);
+        if (Select(level - 1, child_x, child_z, frustum, cam_pos)) {
+            continue;
+        }
+        Vector3d child_min, child_max;
+        if (NodeBox(level - 1, child_x, child_z, child_min, child_max) && frustum.TestBox(child_min, child_max) != FrustumTest::Outside) {
+            chunks_.push_back({ child_x * (size / 2), child_z * (size / 2), size / 2, level });
+        }
+    }
+    return true;
+}
+
+void HeightmapTerrain::EmitChunk(const Chunk& chunk, const Vector3d& cam_pos, VertexStreamSoA& positions, std::vector<uint32_t>& indices) const {
+    // Quads of 2^level cells, cut off where the map ends
+    const uint32_t step = 1u << chunk.level;
+    const uint32_t cells_x = map_.width - 1, cells_z = map_.depth - 1;
+    const uint32_t quads_x = std::min(chunk.size, cells_x - chunk.x + step - 1) / step;
+    const uint32_t quads_z = std::min(chunk.size, cells_z - chunk.z + step - 1) / step;
+    const float morph_start = morph_start_[chunk.level];
+    const float morph_range = ranges_[chunk.level] - morph_start;
+
+    const uint32_t base = (uint32_t)positions.Size();
+    for (uint32_t j = 0; j <= quads_z; ++j) {
+        for (uint32_t i = 0; i <= quads_x; ++i) {
+            // Grid coordinates in steps of this level, chunks start on even ones so parity is the same in every chunk
+            uint32_t gx = chunk.x / step + i, gz = chunk.z / step + j;
+            float x = (float)(gx * step), z = (float)(gz * step);
+
+            // Odd vertices slide onto their even neighbour as the camera moves away, reaching it at the end of the range.
+            // Positions stay in cells until the end, so a vertex fully morphed lands exactly on the coarser one
+            float k = 0.0f;
+            if (morph_start < FLT_MAX) {
+                float cx = std::min(x, (float)cells_x) * map_.cell_size, cz = std::min(z, (float)cells_z) * map_.cell_size;
+                Vector3d p{ cx, map_.Sample(cx, cz), cz };
+                k = std::min(std::max((VectorLength(p - cam_pos) - morph_start) / morph_range, 0.0f), 1.0f);
+            }
+            // The last vertex of a row is moved onto the far edge of the map, which every level has. It stays there,
+            // whatever the parity, the odd vertices before it still land on the even ones of the next level
+            x = (gx * step < cells_x ? x - (float)((gx & 1) * step) * k : (float)cells_x) * map_.cell_size;
+            z = (gz * step < cells_z ? z - (float)((gz & 1) * step) * k : (float)cells_z) * map_.cell_size;
+            positions.PushBack({ x, map_.Sample(x, z), z });
+        }
+    }
+
+    // Two triangles per quad, wound so the normals point up
+    const uint32_t row = quads_x + 1;
+    for (uint32_t j = 0; j < quads_z; ++j) {
+        for (uint32_t i = 0; i < quads_x; ++i) {
+            uint32_t v00 = base + j * row + i;
+            uint32_t v10 = v00 + 1, v01 = v00 + row, v11 = v01 + 1;
+            indices.insert(indices.end(), { v00, v01, v10, v10, v01, v11 });
+        }
+    }
+}
+
+void HeightmapTerrain::Draw(Pipeline& pipeline, const Vector3d& cam_pos, Pipeline::ShadeFunc shade, std::vector<Triangle>& out) {
+    chunks_.clear();
+    if (levels_.empty()) {
+        return;
+    }
+    Select((uint32_t)levels_.size() - 1, 0, 0, pipeline.ViewFrustum(), cam_pos);
+
+    // The vertices depend on the camera through the morph, so the geometry is made again every frame
+    VertexStreamSoA positions;
+    std::vector<uint32_t> indices;
+    for (const Chunk& chunk : chunks_) {
+        EmitChunk(chunk, cam_pos, positions, indices);
+    }
+    mesh_.SetGeometry(std::move(positions), std::move(indices));
+
+    static const Mat4x4 identity = MakeIdentity();
+    pipeline.DrawMesh(mesh_, identity, shade, out);
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "../Loader/Heightmap.h"
+#include "../Primitive/Mesh.h"
+#include "../Render/Pipeline.h"
+
+/**
+ * @brief A terrain generated from a heightmap every frame, with continuous distance based level of detail (CDLOD).
+ *
+ * The map is covered by a quadtree of square chunks. Every chunk, whatever its level, is drawn as the same
+ * grid of chunk_cells x chunk_cells quads, so a chunk one level up covers four times the area at half the
+ * detail. Each level is used up to a distance twice that of the level below it, so the quads keep about the
+ * same size on screen and the triangle count stays about the same however large the map is.
+ *
+ * Nodes are culled against the frustum on their bounding box (the height range below a node is precomputed),
+ * and a node is split while the range of the level below reaches it. Near the end of its range every vertex
+ * with an odd grid coordinate slides onto its even neighbour, so at the end of the range a chunk has become
+ * the grid of the level above it, with degenerate triangles the pipeline drops. Levels therefore change
+ * without popping, and where two levels meet the finer side has finished morphing, so there are no cracks.
+ * The level ranges are kept long enough for that to hold (see SetLod).
+ *
+ * The terrain is in world space, sample (0, 0) of the map at the origin.
+ */
+class HeightmapTerrain {
+public:
+    /**
+     * @brief Use a heightmap and build the quadtree over it.
+     * @param map The heights
+     */
+    void SetHeightmap(Heightmap&& map);
+
+    /**
+     * @brief Load a raw 16-bit heightmap (see LoadHeightmapRaw16) and build the quadtree over it.
+     * @return false if the file cannot be read
+     */
+    bool Open(const std::string& path, uint32_t width, uint32_t depth, float cell_size, float height_scale);
+
+    /**
+     * @brief Set how fine the terrain is, rebuilds the quadtree.
+     * @param chunk_cells Quads along the side of a chunk grid, rounded up to a power of two of at least 4
+     * @param lod_distance Distance up to which the finest level is used, raised if needed so levels meet without cracks
+     */
+    void SetLod(uint32_t chunk_cells, float lod_distance);
+
+    /**
+     * @brief Select the chunks for the camera, generate their vertices and draw them.
+     * @param pipeline The pipeline, after BeginFrame
+     * @param cam_pos Camera position in world space, the one given to BeginFrame
+     * @param shade The shading callback
+     * @param out Receives screen space triangles
+     */
+    void Draw(Pipeline& pipeline, const Vector3d& cam_pos, Pipeline::ShadeFunc shade, std::vector<Triangle>& out);
+
+    /**
+     * @brief Chunks picked by the last Draw.
+     */
+    size_t ChunkCount() const { return chunks_.size(); }
+
+    /**
+     * @brief Triangles generated by the last Draw, before culling in the pipeline.
+     */
+    size_t TriangleCount() const { return mesh_.TriangleCount(); }
+
+    const Heightmap& Map() const { return map_; }
+
+private:
+    /**
+     * @brief A square of the map drawn at one level: cells [x, x + size) by [z, z + size), in map cells.
+     */
+    struct Chunk {
+        uint32_t x, z;
+        uint32_t size;
+        uint32_t level;
+    };
+
+    /**
+     * @brief Heights below the nodes of one level, for their bounding boxes.
+     */
+    struct LevelBounds {
+        uint32_t nodes_x, nodes_z;
+        std::vector<float> min_height, max_height;
+    };
+
+    /**
+     * @brief Rebuild the node height ranges and the level distances after the map or the settings changed.
+     */
+    void Build();
+
+    /**
+     * @brief Pick the chunks below a node.
+     * @return false if the node is beyond the range of its level, so its parent has to cover it
+     */
+    bool Select(uint32_t level, uint32_t node_x, uint32_t node_z, const Frustum& frustum, const Vector3d& cam_pos);
+
+    /**
+     * @brief Bounding box of a node.
+     * @return false if the node lies outside the map
+     */
+    bool NodeBox(uint32_t level, uint32_t node_x, uint32_t node_z, Vector3d& box_min, Vector3d& box_max) const;
+
+    /**
+     * @brief Append the vertices and triangles of a chunk, morphed for the camera.
+     */
+    void EmitChunk(const Chunk& chunk, const Vector3d& cam_pos, VertexStreamSoA& positions, std::vector<uint32_t>& indices) const;
+
+    Heightmap map_;
+    uint32_t chunk_cells_ = 16;
+    float lod_distance_ = 32.0f;
+    std::vector<LevelBounds> levels_;       // Level 0 has one node per chunk_cells cells
+    std::vector<float> ranges_;             // Distance up to which each level is used
+    std::vector<float> morph_start_;        // Distance where each level starts to morph into the next
+    std::vector<Chunk> chunks_;             // Picked by the last Draw
+    Mesh mesh_;                             // Their geometry, rebuilt every Draw
+};
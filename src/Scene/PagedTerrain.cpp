@@ -0,0 +1,236 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include "PagedTerrain.h"
+#include "../Loader/MeshCache.h"
+
+PagedTerrain::PagedTerrain() {
+    worker_ = std::thread(&PagedTerrain::WorkerLoop, this);
+}
+
+PagedTerrain::~PagedTerrain() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    worker_.join();
+}
+
+bool PagedTerrain::Open(const std::string& index_path, size_t budget_bytes) {
+    if (!LoadTerrainIndex(index_path, header_, tiles_)) {
+        return false;
+    }
+    index_path_ = index_path;
+    budget_bytes_ = budget_bytes;
+    pages_.assign(tiles_.size() * 2, Page{});
+    for (size_t t = 0; t < tiles_.size(); ++t) {
+        pages_[t * 2].bytes = tiles_[t].bytes;
+        pages_[t * 2 + 1].bytes = tiles_[t].coarse_bytes;
+    }
+    return true;
+}
+
+void PagedTerrain::SetDistances(float view_distance, float full_distance) {
+    view_distance_ = view_distance;
+    full_distance_ = std::min(full_distance, view_distance);
+}
+
+float PagedTerrain::TileDistance(size_t tile, float x, float z) const {
+    const TerrainTileInfo& info = tiles_[tile];
+    float dx = std::max({ info.bounds_min[0] - x, 0.0f, x - info.bounds_max[0] });
+    float dz = std::max({ info.bounds_min[2] - z, 0.0f, z - info.bounds_max[2] });
+    return std::sqrt(dx * dx + dz * dz);
+}
+
+void PagedTerrain::Update(const Vector3d& cam_pos, const Vector3d& look_dir) {
+    if (tiles_.empty()) {
+        return;
+    }
+    ++frame_;
+
+    // Take what the worker finished, a failed load gives its budget back
+    std::vector<Finished> finished;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        finished.swap(finished_);
+    }
+    for (Finished& f : finished) {
+        Page& page = pages_[f.key];
+        if (!f.mesh) {
+            page.requested = false;
+            page.failed = true;
+            resident_bytes_ -= page.bytes;
+            continue;
+        }
+        page.mesh = std::move(f.mesh);
+        page.lru = lru_.insert(lru_.begin(), f.key);
+    }
+
+    // The point the camera is heading to, on the XZ plane
+    const float cam_x = cam_pos.x, cam_z = cam_pos.z;
+    float ahead_x = cam_x, ahead_z = cam_z;
+    float look_len = std::sqrt(look_dir.x * look_dir.x + look_dir.z * look_dir.z);
+    if (prefetch_distance_ > 0.0f && look_len > 0.0f) {
+        ahead_x += look_dir.x / look_len * prefetch_distance_;
+        ahead_z += look_dir.z / look_len * prefetch_distance_;
+    }
+
+    // Only the grid cells around both points are looked at, so the cost does not grow with the world
+    auto cell = [](float v, float origin, float size, uint32_t count) {
+        return (uint32_t)std::min(std::max((v - origin) / size, 0.0f), (float)(count - 1));
+    };
+    const float reach = view_distance_;
+    uint32_t x0 = cell(std::min(cam_x, ahead_x) - reach, header_.origin[0], header_.tile_size[0], header_.tiles_x);
+    uint32_t x1 = cell(std::max(cam_x, ahead_x) + reach, header_.origin[0], header_.tile_size[0], header_.tiles_x);
+    uint32_t z0 = cell(std::min(cam_z, ahead_z) - reach, header_.origin[1], header_.tile_size[1], header_.tiles_z);
+    uint32_t z1 = cell(std::max(cam_z, ahead_z) + reach, header_.origin[1], header_.tile_size[1], header_.tiles_z);
+
+    // Wanted pages by priority: coarse around the camera, full close to it, then both around the point ahead
+    struct Wanted {
+        int band;
+        float distance;
+        uint32_t key;
+    };
+    std::vector<Wanted> wanted;
+    draw_tiles_.clear();
+    for (uint32_t tz = z0; tz <= z1; ++tz) {
+        for (uint32_t tx = x0; tx <= x1; ++tx) {
+            uint32_t tile = tz * header_.tiles_x + tx;
+            if (tiles_[tile].triangles == 0) {
+                continue;
+            }
+            float d = TileDistance(tile, cam_x, cam_z);
+            float d_ahead = TileDistance(tile, ahead_x, ahead_z);
+            if (d <= view_distance_) {
+                draw_tiles_.push_back({ tile, d <= full_distance_ });
+                wanted.push_back({ 0, d, tile * 2 + 1 });
+            }
+            else if (d_ahead <= view_distance_) {
+                wanted.push_back({ 2, d_ahead, tile * 2 + 1 });
+            }
+            if (d <= full_distance_) {
+                wanted.push_back({ 1, d, tile * 2 });
+            }
+            else if (d_ahead <= full_distance_) {
+                wanted.push_back({ 2, d_ahead, tile * 2 });
+            }
+        }
+    }
+    std::sort(wanted.begin(), wanted.end(), [](const Wanted& a, const Wanted& b) {
+        return a.band != b.band ? a.band < b.band : a.distance < b.distance;
+    });
+
+    // Mark everything first so no wanted page is evicted for another one
+    for (const Wanted& w : wanted) {
+        Page& page = pages_[w.key];
+        page.last_used = frame_;
+        if (page.mesh) {
+            lru_.splice(lru_.begin(), lru_, page.lru);
+        }
+    }
+    for (const Wanted& w : wanted) {
+        if (!Want(w.key)) {
+            break;
+        }
+    }
+}
+
+bool PagedTerrain::Want(uint32_t key) {
+    Page& page = pages_[key];
+    if (page.requested || page.failed) {
+        return true;
+    }
+    if (page.bytes > budget_bytes_) {
+        return false;
+    }
+
+    // Make room from the least recently used end
+    while (resident_bytes_ + page.bytes > budget_bytes_) {
+        if (lru_.empty() || pages_[lru_.back()].last_used == frame_) {
+            return false;
+        }
+        Page& victim = pages_[lru_.back()];
+        victim.mesh.reset();
+        victim.requested = false;
+        resident_bytes_ -= victim.bytes;
+        lru_.pop_back();
+    }
+
+    page.requested = true;
+    resident_bytes_ += page.bytes;
+    uint32_t tile = key / 2;
+    std::string path = TerrainTilePath(index_path_, tile % header_.tiles_x, tile / header_.tiles_x, key % 2 == 1);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        requests_.push_back({ key, std::move(path) });
+    }
+    wake_.notify_one();
+    return true;
+}
+
+void PagedTerrain::Draw(Pipeline& pipeline, Pipeline::ShadeFunc shade, std::vector<Triangle>& out, DepthPyramid* occluders) const {
+    static const Mat4x4 identity = MakeIdentity();
+    Frustum frustum = pipeline.ViewFrustum();
+
+    // With occluders the close tiles go first (pass 0) and the far ones after them (pass 1)
+    for (int pass = 0; pass < 2; ++pass) {
+        size_t first_out = out.size();
+        for (const DrawTile& d : draw_tiles_) {
+            if (occluders && d.near != (pass == 0)) {
+                continue;
+            }
+
+            // Tiles behind the camera or off to the side are skipped on their box before their meshlets are looked at
+            const TerrainTileInfo& info = tiles_[d.tile];
+            if (frustum.TestBox(info.bounds_min, info.bounds_max) == FrustumTest::Outside) {
+                continue;
+            }
+            const Mesh* full = pages_[d.tile * 2].mesh.get();
+            const Mesh* coarse = pages_[d.tile * 2 + 1].mesh.get();
+
+            // A far tile uses its coarse copy even if the full one is still around, a near one falls back to it
+            const Mesh* mesh = d.near ? (full ? full : coarse) : (coarse ? coarse : full);
+            if (mesh) {
+                pipeline.DrawMesh(*mesh, identity, shade, out);
+            }
+        }
+        if (!occluders) {
+            break;
+        }
+        if (pass == 0) {
+            for (size_t i = first_out; i < out.size(); ++i) {
+                occluders->AddOccluder(out[i]);
+            }
+            occluders->Build();
+            pipeline.SetOcclusion(occluders);
+        }
+        else {
+            pipeline.SetOcclusion(nullptr);
+        }
+    }
+}
+
+void PagedTerrain::WorkerLoop() {
+    for (;;) {
+        Request request;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this] { return stop_ || !requests_.empty(); });
+            if (stop_) {
+                return;
+            }
+            request = std::move(requests_.front());
+            requests_.pop_front();
+        }
+
+        auto mesh = std::make_shared<Mesh>();
+        if (!LoadMeshCache(request.path, *mesh)) {
+            std::cerr << "The terrain tile " << request.path << " cannot be loaded.\n";
+            mesh.reset();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        finished_.push_back({ request.key, std::move(mesh) });
+    }
+}
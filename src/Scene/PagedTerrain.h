@@ -0,0 +1,147 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../Loader/TerrainTiles.h"
+#include "../Primitive/Mesh.h"
+#include "../Render/Pipeline.h"
+
+/**
+ * @brief A tiled terrain (see TerrainTiles.h) streamed from disk within a memory budget.
+ *
+ * Every frame Update() works out which tiles the camera needs: the coarse copy of every tile within the
+ * view distance, and the full tile for the ones close by. The same is done around a point ahead of the
+ * camera along its look direction, at a lower priority, so the tiles it is heading to are already loading.
+ * A worker thread maps the tile files, Update() only picks up what it finished, so a frame never waits
+ * on the disk. Tiles are kept in least recently used order and the oldest ones are dropped when the bytes
+ * of the loaded tiles would go over the budget, so memory stays bounded however large the world is.
+ *
+ * Draw() draws the full tile where it is loaded, otherwise the coarse one, and skips a tile with neither
+ * until it arrives. The terrain is in world space. Given a depth pyramid, the close tiles are drawn first and
+ * become the occluders of the far ones, so the parts of the terrain behind a ridge are never transformed.
+ */
+class PagedTerrain {
+public:
+    PagedTerrain();
+    ~PagedTerrain();
+    PagedTerrain(const PagedTerrain&) = delete;
+    PagedTerrain& operator=(const PagedTerrain&) = delete;
+
+    /**
+     * @brief Read the index of a terrain, no tile is loaded yet. Call it once.
+     * @param index_path Path of the index file
+     * @param budget_bytes Most bytes of tile files loaded at once
+     * @return false if the index cannot be read
+     */
+    bool Open(const std::string& index_path, size_t budget_bytes);
+
+    /**
+     * @brief How far tiles are drawn, and up to where they are drawn at full detail.
+     * @param view_distance Tiles further than this on the XZ plane are neither loaded nor drawn
+     * @param full_distance Tiles closer than this get their full version
+     */
+    void SetDistances(float view_distance, float full_distance);
+
+    /**
+     * @brief How far ahead of the camera tiles are prefetched.
+     * @param distance Distance along the look direction, 0 turns prefetching off
+     */
+    void SetPrefetchDistance(float distance) { prefetch_distance_ = distance; }
+
+    /**
+     * @brief Take the finished loads, then request and evict tiles for the camera. Call once per frame.
+     * @param cam_pos Camera position in world space
+     * @param look_dir Camera look direction
+     */
+    void Update(const Vector3d& cam_pos, const Vector3d& look_dir);
+
+    /**
+     * @brief Draw the tiles picked by the last Update.
+     * @param pipeline The pipeline, after BeginFrame
+     * @param shade The shading callback
+     * @param out Receives screen space triangles
+     * @param occluders Cleared by the caller for this frame, or nullptr. The close tiles are added to it and
+     * the far ones are culled against it, the pipeline has occlusion culling off again afterwards
+     */
+    void Draw(Pipeline& pipeline, Pipeline::ShadeFunc shade, std::vector<Triangle>& out, DepthPyramid* occluders = nullptr) const;
+
+    /**
+     * @return Bytes of the loaded tiles, and of the ones being loaded
+     */
+    size_t ResidentBytes() const { return resident_bytes_; }
+
+    /**
+     * @return Number of tile versions loaded, full and coarse counted apart
+     */
+    size_t ResidentCount() const { return lru_.size(); }
+
+private:
+    /**
+     * @brief The full or the coarse version of a tile. Key is tile * 2 + (1 for coarse).
+     */
+    struct Page {
+        std::shared_ptr<const Mesh> mesh;   // nullptr until loaded
+        uint64_t bytes = 0;                 // Size of the file, counted against the budget from the request on
+        uint64_t last_used = 0;             // Frame of the last Update that wanted it
+        bool requested = false;             // Loading or loaded
+        bool failed = false;                // The file could not be loaded, it is not asked for again
+        std::list<uint32_t>::iterator lru;  // Position in lru_ once loaded
+    };
+
+    struct Request {
+        uint32_t key;
+        std::string path;
+    };
+
+    struct Finished {
+        uint32_t key;
+        std::shared_ptr<const Mesh> mesh;   // nullptr if the load failed
+    };
+
+    struct DrawTile {
+        uint32_t tile;
+        bool near;                          // Within the full distance, the full version is preferred
+    };
+
+    /**
+     * @brief Request a page if it is not there yet and the budget allows, making room by eviction.
+     * @return false if the budget is full of pages wanted this frame, lower priorities are not worth trying
+     */
+    bool Want(uint32_t key);
+
+    /**
+     * @brief Distance on the XZ plane from a point to the box of a tile.
+     */
+    float TileDistance(size_t tile, float x, float z) const;
+
+    /**
+     * @brief The worker thread: map the requested tile files.
+     */
+    void WorkerLoop();
+
+    std::string index_path_;
+    TerrainIndexHeader header_{};
+    std::vector<TerrainTileInfo> tiles_;
+    std::vector<Page> pages_;               // Two per tile
+    std::list<uint32_t> lru_;               // Loaded pages, most recently used first
+    std::vector<DrawTile> draw_tiles_;      // Tiles within the view distance at the last Update
+    size_t budget_bytes_ = 0;
+    size_t resident_bytes_ = 0;
+    uint64_t frame_ = 0;
+    float view_distance_ = 200.0f;
+    float full_distance_ = 60.0f;
+    float prefetch_distance_ = 60.0f;
+
+    std::mutex mutex_;                      // Guards the three below, shared with the worker
+    std::condition_variable wake_;
+    std::deque<Request> requests_;
+    std::vector<Finished> finished_;
+    bool stop_ = false;
+    std::thread worker_;
+};
@@ -0,0 +1,10 @@
+#include "Transform.h"
+
+void Transform::Rebuild() {
+    // Rotation then translation, the translation is simply the last row
+    matrix_ = QuaternionToMatrix(rotation_);
+    matrix_.m[3][0] = position_.x;
+    matrix_.m[3][1] = position_.y;
+    matrix_.m[3][2] = position_.z;
+    dirty_ = false;
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include "../Maths/Quaternion/Quaternion.h"
+
+/**
+ * @brief Position and rotation of an object. The world matrix is cached and only rebuilt after a change,
+ * so objects that did not move cost nothing per frame.
+ */
+class Transform {
+public:
+    /**
+     * @brief Move the object to a new position.
+     * @param position The position in world space
+     */
+    void SetPosition(const Vector3d& position) {
+        position_ = position;
+        dirty_ = true;
+    }
+
+    /**
+     * @brief Replace the rotation.
+     * @param rotation The new rotation, must be unit length
+     */
+    void SetRotation(const Quaternion& rotation) {
+        rotation_ = rotation;
+        dirty_ = true;
+    }
+
+    /**
+     * @brief Rotate further, applied after the current rotation.
+     * @param delta The extra rotation
+     */
+    void Rotate(const Quaternion& delta) {
+        rotation_ = NormalizeQuaternion(rotation_ * delta);
+        dirty_ = true;
+    }
+
+    const Vector3d& Position() const { return position_; }
+    const Quaternion& Rotation() const { return rotation_; }
+
+    /**
+     * @brief The world matrix, rotation followed by translation.
+     * @return The cached matrix, rebuilt first if the transform changed
+     */
+    const Mat4x4& Matrix() {
+        if (dirty_) {
+            Rebuild();
+        }
+        return matrix_;
+    }
+
+private:
+    /**
+     * @brief Rebuild the cached matrix from position and rotation.
+     */
+    void Rebuild();
+
+    Vector3d position_;                 // Position in world space
+    Quaternion rotation_;               // Rotation, applied before the translation
+    Mat4x4 matrix_ = MakeIdentity();    // Cached world matrix
+    bool dirty_ = true;                 // Whether matrix_ is out of date
+};
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief A non-owning view of count contiguous T, the C++17 stand-in for std::span.
+ * It does not keep the memory alive: whoever owns it (a vector, a mapped file) must outlive the view.
+ */
+template <typename T>
+class Span {
+public:
+    constexpr Span() = default;
+    constexpr Span(T* data, size_t count) : data_(data), size_(count) {}
+
+    /**
+     * @brief View of a whole vector, a vector<U> can be seen as a Span<const U>.
+     */
+    template <typename U, typename = std::enable_if_t<std::is_same<std::remove_const_t<T>, U>::value>>
+    Span(std::vector<U>& vec) : data_(vec.data()), size_(vec.size()) {}
+
+    template <typename U, typename = std::enable_if_t<std::is_same<T, const U>::value>>
+    Span(const std::vector<U>& vec) : data_(vec.data()), size_(vec.size()) {}
+
+    /**
+     * @brief A Span<T> can be seen as a Span<const T>.
+     */
+    template <typename U, typename = std::enable_if_t<std::is_same<T, const U>::value>>
+    constexpr Span(const Span<U>& other) : data_(other.Data()), size_(other.Size()) {}
+
+    constexpr T* Data() const { return data_; }
+    constexpr size_t Size() const { return size_; }
+    constexpr bool Empty() const { return size_ == 0; }
+
+    constexpr T& operator[](size_t i) const { return data_[i]; }
+
+    /**
+     * @brief Part of the view.
+     * @param offset First element
+     * @param count Number of elements
+     * @return The elements [offset, offset + count)
+     */
+    constexpr Span Sub(size_t offset, size_t count) const { return Span(data_ + offset, count); }
+
+    // For range-for
+    constexpr T* begin() const { return data_; }
+    constexpr T* end() const { return data_ + size_; }
+
+private:
+    T* data_ = nullptr;
+    size_t size_ = 0;
+};
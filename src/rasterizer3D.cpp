@@ -9,10 +9,17 @@
 
 #include <algorithm>
 #include "olcConsoleGameEngine.h"
+#include "Loader/AsyncMeshLoader.h"
 #include "Maths/Vector/Vector3d.h"
 #include "Maths/Matrix/Mat4x4.h"
 #include "Primitive/Triangle.h"
 #include "Primitive/Mesh.h"
+#include "Primitive/MeshLod.h"
+#include "Render/Clipping.h"
+#include "Render/Pipeline.h"
+#include "Render/Rasterizer.h"
+#include "Scene/Camera.h"
+#include "Scene/Transform.h"
 
 /**
  * @brief A new class inherit from olcConsoleGameEngine
@@ -28,18 +35,31 @@ public:
      * @return true if successfully created, otherwise false.
      */
     bool OnUserCreate() override {
-        // Using load file
-        mesh_cube_.LoadFromObjFile("mountains.obj");
+        // Load in the background, the frames start right away and the mesh shows up once it is ready.
+        // Editing the file reloads it. The camera starts inside the mesh bounds, where only the full level
+        // is ever picked, so no coarser levels are built
+        mesh_cube_ = loader_.Load("mountains.obj", MeshLoadOptions());
+        loader_.SetHotReload(true);
+
+        // The camera moves smoothly, so what was visible last frame is drawn first and occludes the rest
+        pipeline_.SetTemporalOcclusion(true);
         
         // Projection Matrix
         float near_plane = 0.1f;
         float far_plane = 1000.0f;
         float fov = 90.0f;  // FOV as usual
         float aspect_ratio = (float)ScreenHeight() / (float)ScreenWidth();
-        cam_ = { 0.0f, 0.0f, 0.0f };    // The cam are set to origin for simplicity
+        camera_.SetPosition({ 0.0f, 0.0f, 0.0f });    // The cam are set to origin for simplicity
 
         // Setting up the projection matrix
-        mat_projection_ = MakeProjection(fov, aspect_ratio, near_plane, far_plane);
+        camera_.SetProjection(fov, aspect_ratio, near_plane, far_plane);
+
+        // World transform of the mesh: rotate around Z by half theta then around X by theta, and push it away.
+        // The matrix is built once here and cached by the Transform until something changes it
+        Quaternion rot_z = QuaternionFromAxisAngle({ 0.0f, 0.0f, 1.0f }, theta_ * 0.5f);
+        Quaternion rot_x = QuaternionFromAxisAngle({ 1.0f, 0.0f, 0.0f }, theta_);
+        mesh_transform_.SetRotation(rot_z * rot_x);
+        mesh_transform_.SetPosition({ 0.0f, 0.0f, 16.0f });
 
         // Return true to indicate it works without error.
         return true;
@@ -54,163 +74,57 @@ public:
 
         // User Control using arrow keys
         if (GetKey(VK_UP).bHeld) {
-            cam_.y += 8.0f * delta_time;
+            camera_.Translate({ 0.0f, 8.0f * delta_time, 0.0f });
         }
 
         if (GetKey(VK_DOWN).bHeld) {
-            cam_.y -= 8.0f * delta_time;
+            camera_.Translate({ 0.0f, -8.0f * delta_time, 0.0f });
         }
 
         if (GetKey(VK_LEFT).bHeld) {
-            cam_.x -= 8.0f * delta_time;
+            camera_.Translate({ -8.0f * delta_time, 0.0f, 0.0f });
         }
 
         if (GetKey(VK_RIGHT).bHeld) {
-            cam_.x += 8.0f * delta_time;
+            camera_.Translate({ 8.0f * delta_time, 0.0f, 0.0f });
         }
 
         // FPS control
         // we make a forward velocity vector
-        Vector3d forward = VectorMul(look_dir_, 8.0f * delta_time);
+        Vector3d forward = VectorMul(camera_.LookDir(), 8.0f * delta_time);
 
         if (GetKey(L'W').bHeld) {
-            cam_ = VectorAdd(cam_, forward);
+            camera_.Translate(forward);
         }
 
         if (GetKey(L'S').bHeld) {
-            cam_ = VectorSub(cam_, forward);
+            camera_.Translate(VectorMul(forward, -1.0f));
         }
 
         if (GetKey(L'A').bHeld) {
-            yaw_ -= 2.0f * delta_time;
+            camera_.AddYaw(-2.0f * delta_time);
         }
 
         if (GetKey(L'D').bHeld) {
-            yaw_ += 2.0f * delta_time;
+            camera_.AddYaw(2.0f * delta_time);
         }
 
-        // Now we move the transformation outside the for loop, and make it a whole transform matrix
-        
-        // Rotation Z and X matrices
-        Mat4x4 mat_rot_z, mat_rot_x;
-        mat_rot_z = MakeRotationZ(theta_ * 0.5f);
-        mat_rot_x = MakeRotationX(theta_);
-
-        // Translation matrix
-        Mat4x4 mat_trans = MakeTranslation(0.0f, 0.0f, 16.0f);
-
-        // World matrix, Final transformation matrix
-        Mat4x4 mat_world = MakeIdentity();
-        mat_world = MultiplyMatrix(mat_rot_z, mat_rot_x);
-        mat_world = MultiplyMatrix(mat_world, mat_trans);
-        
-        // Helper Up vector
-        Vector3d up = { 0.0f, 1.0f, 0.0f };
-
-        Vector3d target = { 0.0f, 0.0f, 1.0f };
-        Mat4x4 mat_cam_rot = MakeRotationY(yaw_);
-
-        look_dir_ = MultiplyMatrixVector(target, mat_cam_rot);
-        target = VectorAdd(cam_, look_dir_);
-
-        // Camera matrix
-        Mat4x4 mat_cam = PointAt(cam_, target, up);
-
-        // View matrix/Inverse
-        Mat4x4 mat_view = Inverse(mat_cam);
+        // World and view matrices are only rebuilt when the mesh or the camera changed
+        const Mat4x4& mat_world = mesh_transform_.Matrix();
+        const Mat4x4& mat_view = camera_.View();
 
         // In order to use painter algorithm, we need a new array to cache the triangles
         std::vector<Triangle> sort_tri_raster;
 
-        // Draw Triangles/Mesh, so far we only have a vector array of Triangles.
-        // thus, we use for loop
-        for (auto& tri : mesh_cube_.tris) {
-            // This represent 3 different stage of rendering pipeline
-            Triangle triangle_proj{}, triangle_transform{}, triangle_view{};
-
-            // Make the Transform
-            for (int i = 0; i < 3; ++i) {
-                triangle_transform.pts[i] = MultiplyMatrixVector(tri.pts[i], mat_world);
-            }
-
-            // Calculate the normal first before the projection
-            Vector3d normal{}, line_1{}, line_2{};
-            VectorSub(triangle_transform.pts[1], triangle_transform.pts[0], line_1);
-            VectorSub(triangle_transform.pts[2], triangle_transform.pts[0], line_2);
-            CrossProduct(line_1, line_2, normal);
-            Normalize(normal);
-
-            /**
-             * Now we actually have a camera, we want to make sure the normal is facing the camera direction, 
-             * so we introduce a dot product here. 
-             * And we can take any points on the triangle as they are all on the same plane.
-             */
-
-            Vector3d cam_ray = VectorSub(triangle_transform.pts[0], cam_);
-
-            if (DotProduct(normal, cam_ray) < 0) {
-
-                // Illumination before projection, temporarily
-                Vector3d light_dir = { 0.0f, 1.0f, -1.0f };
-                Normalize(light_dir);
-
-                // How "aligned" are light direction and triangle surface normal?
-                float dp = max(0.1f, DotProduct(light_dir, normal));
-
-                // Get the color by using the dot product.
-                CHAR_INFO c = GetColor(dp);
-                triangle_transform.sym = c.Char.UnicodeChar;
-                triangle_transform.col = c.Attributes;
-
-                // Before projection, we want to Convert world space --> camera space/view space
-                for (int i = 0; i < 3; ++i) {
-                    triangle_view.pts[i] = MultiplyMatrixVector(triangle_transform.pts[i], mat_view);
-                }
-
-                triangle_view.col = triangle_transform.col;
-                triangle_view.sym = triangle_transform.sym;
-
-                // Clip views 
-                int clipped_cnt = 0;
-                Triangle clipped[2];
-                clipped_cnt = ClipAgainstPlane({ 0.0f, 0.0f, 2.1f }, { 0.0f, 0.0f, 1.0f }, triangle_view, clipped[0], clipped[1]);
-
-
-                for (int n = 0; n < clipped_cnt; ++n) {
-                    // Projection from 3D ---> 2D
-                    for (int i = 0; i < 3; ++i) {
-                        // Projection
-                        MultiplyMatrixVector(clipped[n].pts[i], triangle_proj.pts[i], mat_projection_);
-                    }
-                    triangle_proj.col = clipped[n].col;
-                    triangle_proj.sym = clipped[n].sym;
-                    
-
-                    for (int i = 0; i < 3; ++i) {
-                        // Normalize
-                        triangle_proj.pts[i] = VectorDiv(triangle_proj.pts[i], triangle_proj.pts[i].w);
-                    }
-
-                    // The axis are upside down, change them back
-                    for (int i = 0; i < 3; ++i) {
-                        triangle_proj.pts[i].x *= -1.0f;
-                        triangle_proj.pts[i].y *= -1.0f;
-                    }
-
-                    // Scaling the Triangle
-                    // Offset vector
-                    Vector3d offset = { 1, 1, 0 };
-                    for (int i = 0; i < 3; ++i) {
-                        triangle_proj.pts[i] = VectorAdd(triangle_proj.pts[i], offset);
-                        triangle_proj.pts[i].x *= 0.5f * (float)ScreenWidth();
-                        triangle_proj.pts[i].y *= 0.5f * (float)ScreenHeight();
-                    }
-
-                    // Push them into the triangle cache
-                    sort_tri_raster.push_back(triangle_proj);
-                }
-            }
+        // Geometry stage: one combined world * view * projection * viewport matrix per mesh
+        pipeline_.BeginFrame(mat_view, camera_.Projection(), (float)ScreenWidth(), (float)ScreenHeight(), camera_.Position(), 2.1f);
+        // Hold on to this version for the frame, a reload may publish the next one meanwhile
+        std::shared_ptr<const MeshLod> mesh = mesh_cube_->Current();
+        if (mesh) {
+            pipeline_.DrawMesh(*mesh, mat_world, &NewEngine::ShadeTriangle, sort_tri_raster);
         }
+        // What was hidden last frame is drawn only if the depth of the rest no longer hides it
+        pipeline_.ResolveOcclusion();
 
         // Sort them using painter algo
         std::sort(sort_tri_raster.begin(), sort_tri_raster.end(), [](Triangle& t_1, Triangle& t_2) {
@@ -266,8 +180,14 @@ public:
             }
 
             for (auto& t : triangle_list) {
-                // Rasterize triangle, Now the olc console engine has the function call fillTriangle
-                FillTriangle(t.pts[0].x, t.pts[0].y, t.pts[1].x, t.pts[1].y, t.pts[2].x, t.pts[2].y, t.sym, t.col);
+                // Rasterize triangle with sub-pixel precision, shared edges are only filled once
+                Fixed28_4 x[3], y[3];
+                for (int i = 0; i < 3; ++i) {
+                    x[i] = ToFixed28_4(t.pts[i].x);
+                    y[i] = ToFixed28_4(t.pts[i].y);
+                }
+                DrawSpanTarget target{ this, &t };
+                FillTriangleFixed(x, y, ScreenWidth(), ScreenHeight(), &NewEngine::DrawSpan, &target);
             }
         }
 
@@ -276,18 +196,26 @@ public:
     }
 
 private:
-    Mesh mesh_cube_;        // A Mesh used in default
-    Mat4x4 mat_projection_; // A project matrix
-    Vector3d cam_;          // A temporary camera currently, we set it to the origin first
-    Vector3d look_dir_;     // The look at direction, should be unit length
-    float theta_;           // Rotation angle
-    float yaw_;             // An angle for FPS look direction
+    AsyncMeshLoader loader_;    // Loads and reloads meshes off the frame loop
+    std::shared_ptr<MeshAsset> mesh_cube_;  // A Mesh used in default, with its levels of detail
+    Pipeline pipeline_;     // The geometry stage
+    Transform mesh_transform_;  // Where mesh_cube_ sits in the world
+    Camera camera_;         // The FPS camera, owns the view and projection matrices
+    float theta_ = 0.0f;    // Rotation angle of the mesh
+
+    /**
+     * @brief What DrawSpan needs to know, passed through the rasterizer as its user pointer.
+     */
+    struct DrawSpanTarget {
+        NewEngine* engine;
+        const Triangle* tri;
+    };
 
     // ===================== Things are getting messy, maybe I should make this into another file ================ //
 
     // =========== Color code from Other Library ========= //
     // Taken From Command Line Webcam Video
-    CHAR_INFO GetColor(float lum)
+    static CHAR_INFO GetColor(float lum)
     {
         short bg_col, fg_col;
         wchar_t sym;
@@ -321,99 +249,28 @@ private:
     }
 
     /**
-     * @brief This performs clipping triangles, checking whether the triangle should be renderred or not, or render parts of them
-     * @param plane_p The frustum boarder plane point
-     * @param normal The normal of the plane
-     * @param in_tri The input triangle
-     * @param out_tri_1 The placeholder for output
-     * @param out_tri_2 The other placeholder 
-     * @return Integer representing how many triangles are output
+     * @brief Span callback for the rasterizer, writes one row of a triangle straight into the screen buffer.
+     * @param user The engine, followed by the triangle being drawn (see DrawSpanTarget)
+     * @param span The covered pixels
      */
-    int ClipAgainstPlane(Vector3d plane_p, Vector3d normal, Triangle& in_tri, Triangle& out_tri_1, Triangle& out_tri_2) {
-        // Normal should be normalized
-        Normalize(normal);
-
-        // Return signed shortest distance from point to plane, plane normal must be normalized
-        auto dist = [&](Vector3d& p) {
-            return (normal.x * p.x + normal.y * p.y + normal.z * p.z - DotProduct(normal, plane_p));
-        };
-
-        // Create two temporary storage arrays to classify points either side of plane
-        // If distance sign is positive, point lies on "inside" of plane
-        Vector3d* inside_pts[3]{};
-        Vector3d* outside_pts[3]{};
-
-        int cnt_inside = 0, cnt_outside = 0;
-
-        // Get signed distance of each point in triangle to plane
-        float d0 = dist(in_tri.pts[0]);
-        float d1 = dist(in_tri.pts[1]);
-        float d2 = dist(in_tri.pts[2]);
-
-        if (d0 >= 0) {
-            inside_pts[cnt_inside++] = &in_tri.pts[0];
-        }
-        else {
-            outside_pts[cnt_outside++] = &in_tri.pts[0];
-        }
-
-        if (d1 >= 0) {
-            inside_pts[cnt_inside++] = &in_tri.pts[1];
-        }
-        else {
-            outside_pts[cnt_outside++] = &in_tri.pts[1];
-        }
-
-        if (d2 >= 0) {
-            inside_pts[cnt_inside++] = &in_tri.pts[2];
-        }
-        else {
-            outside_pts[cnt_outside++] = &in_tri.pts[2];
-        }
-
-        // 4 possible case
-        if (cnt_inside == 0) {
-            // The triangle is outside of the frustum
-            return 0;
-        }
-
-        if (cnt_inside == 3) {
-            // All points line inside of the frustum
-            out_tri_1 = in_tri;
-
-            return 1;
-        }
-
-        if (cnt_inside == 1 && cnt_outside == 2) {
-            
-            // Triangle should be clipped. As two points lie outside
-            // the plane, the triangle simply becomes a smaller triangle
-
-            out_tri_1.col = in_tri.col;
-            out_tri_1.sym = in_tri.sym;
-
-            out_tri_1.pts[0] = *inside_pts[0];
-            out_tri_1.pts[1] = IntersectPlane(plane_p, normal, *inside_pts[0], *outside_pts[0]);
-            out_tri_1.pts[2] = IntersectPlane(plane_p, normal, *inside_pts[0], *outside_pts[1]);
-            return 1;
+    static void DrawSpan(void* user, const RasterSpan& span) {
+        DrawSpanTarget* target = static_cast<DrawSpanTarget*>(user);
+        CHAR_INFO* row = target->engine->m_bufScreen + span.y * target->engine->m_nScreenWidth;
+        for (int x = span.x_begin; x < span.x_end; ++x) {
+            row[x].Char.UnicodeChar = target->tri->sym;
+            row[x].Attributes = target->tri->col;
         }
+    }
 
-        if (cnt_inside == 2 && cnt_outside == 1) {
-            // Make quad to be two triangles
-            out_tri_1.col = in_tri.col;
-            out_tri_1.sym = in_tri.sym;
-            out_tri_2.col = in_tri.col;
-            out_tri_2.sym = in_tri.sym;
-
-            out_tri_1.pts[0] = *inside_pts[0];
-            out_tri_1.pts[1] = *inside_pts[1];
-            out_tri_1.pts[2] = IntersectPlane(plane_p, normal, *inside_pts[0], *outside_pts[0]);
-
-            out_tri_2.pts[0] = *inside_pts[1];
-            out_tri_2.pts[1] = out_tri_1.pts[2];
-            out_tri_2.pts[2] = IntersectPlane(plane_p, normal, *inside_pts[1], *outside_pts[0]);
-            return 2;
-        }
+    /**
+     * @brief Shading callback for the pipeline, stores the console symbol and colour for the light value.
+     * @param lum Light intensity between 0 and 1
+     * @param tri The triangle to shade
+     */
+    static void ShadeTriangle(float lum, Triangle& tri) {
+        CHAR_INFO c = GetColor(lum);
+        tri.sym = c.Char.UnicodeChar;
+        tri.col = c.Attributes;
     }
 };
 